@@ -4,6 +4,7 @@
 #include "Scene.h"
 #include "FileParser.h"
 #include "AboutScene.h"
+#include "Profiler.h"
 
 extern Scene menuScene;
 
@@ -42,7 +43,7 @@ void AboutScene::onRedButtonPress() {
 #    endif
 #else
     next_layout(1);
-    reDisplay();
+    request_redraw();
 #endif
 }
 
@@ -54,6 +55,14 @@ void AboutScene::onTouchClick() {
     }
 }
 
+#ifdef PROFILER
+// A long touch shows or hides the profiler overlay, and prints the timings
+void AboutScene::onTouchHold() {
+    profile_toggle_overlay();
+    request_redraw();
+}
+#endif
+
 void AboutScene::onEncoder(int delta) {
     if (delta > 0 && _brightness < 255) {
         display.setBrightness(++_brightness);
@@ -63,10 +72,10 @@ void AboutScene::onEncoder(int delta) {
         display.setBrightness(--_brightness);
         setPref("brightness", _brightness);
     }
-    reDisplay();
+    request_redraw();
 }
 void AboutScene::onStateChange(state_t old_state) {
-    reDisplay();
+    request_redraw();
 }
 void AboutScene::reDisplay() {
     background();
@@ -92,6 +101,21 @@ void AboutScene::reDisplay() {
     text(intToCStr(_brightness), val_x, y, GREEN, TINY, bottom_left);
 #endif
 
+#ifdef ARDUINO
+    // Peak bytes waiting in the UART driver, against its buffer size
+    size_t   rx_peak, rx_size;
+    uint32_t rx_overflows, rx_lost;
+    fnc_rx_stats(rx_peak, rx_size, rx_overflows, rx_lost);
+    std::string rx_str = std::to_string(rx_peak) + "/" + std::to_string(rx_size);
+    text("FNC RX peak:", key_x, y += y_spacing, LIGHTGREY, TINY, bottom_right);
+    text(rx_str, val_x, y, rx_overflows ? RED : GREEN, TINY, bottom_left);
+#endif
+
+#ifdef PROFILER
+    text("Profiler:", key_x, y += y_spacing, LIGHTGREY, TINY, bottom_right);
+    text(profile_overlay_enabled() ? "shown" : "hold to show", val_x, y, GREEN, TINY, bottom_left);
+#endif
+
     if (wifi_ssid.length()) {
         std::string wifi_str = wifi_mode;
         if (wifi_mode == "No Wifi") {
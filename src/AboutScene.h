@@ -14,6 +14,9 @@ public:
     void onRedButtonPress();
 
     void onTouchClick() override;
+#ifdef PROFILER
+    void onTouchHold() override;
+#endif
 
     void onEncoder(int delta);
     void onStateChange(state_t old_state);
@@ -0,0 +1,99 @@
+// Copyright (c) 2024 - Mitch Bradley
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "CommandQueue.h"
+#include "FluidNCModel.h"
+#include "ProtocolTask.h"  // run_on_ui()
+
+extern "C" void show_timeout();
+
+CommandQueue commands;
+
+void CommandQueue::update_count() {
+    lines_in_flight = _waiting.size() + _in_flight.size();
+}
+
+void CommandQueue::add(const char* line, int timeout, const command_done_t& done) {
+    _waiting.push_back({ line, timeout, done, 0, false });
+    update_count();
+}
+
+void CommandQueue::finish(command_t& cmd, int status) {
+    uint32_t latency = milliseconds() - cmd.sent_ms;
+    if (status == CMD_TIMEOUT) {
+        ++_timeouts;
+    } else {
+        if (status) {
+            ++_errors;
+        }
+        if (latency > _max_latency) {
+            _max_latency = latency;
+        }
+        _avg_latency = _completed ? _avg_latency - _avg_latency / 8 + latency : latency * 8;
+        ++_completed;
+    }
+    if (cmd.done) {
+        command_done_t done = cmd.done;
+        run_on_ui([done, status, latency] { done(status, latency); });
+    }
+}
+
+void CommandQueue::poll() {
+    int now = milliseconds();
+
+    for (auto& cmd : _in_flight) {
+        if (!cmd.expired && cmd.timeout != CMD_NO_TIMEOUT && now - cmd.sent_ms >= cmd.timeout) {
+            cmd.expired = true;
+            show_timeout();
+            finish(cmd, CMD_TIMEOUT);
+            cmd.done = nullptr;
+        }
+    }
+
+    while (_waiting.size() && _in_flight.size() < CMD_WINDOW) {
+        command_t& cmd = _waiting.front();
+        size_t     len = cmd.line.length() + 1;
+        // A line longer than the buffer can only go out on its own
+        if (_in_flight.size() && _in_flight_bytes + len > CMD_RX_BYTES) {
+            break;
+        }
+        for (char c : cmd.line) {
+            fnc_putchar(c);
+        }
+        fnc_putchar('\n');
+        cmd.sent_ms = now;
+        _in_flight_bytes += len;
+        _in_flight.push_back(std::move(cmd));
+        _waiting.pop_front();
+    }
+}
+
+void CommandQueue::complete(int status) {
+    if (_in_flight.empty()) {
+        return;  // A response to a line typed on the debug port
+    }
+    // Taken off the queue first, as the callback may queue more commands
+    command_t cmd = std::move(_in_flight.front());
+    _in_flight.pop_front();
+    _in_flight_bytes -= cmd.line.length() + 1;
+    update_count();
+    if (!cmd.expired) {
+        finish(cmd, status);
+    }
+    poll();
+}
+
+void CommandQueue::clear() {
+    _waiting.clear();
+    _in_flight.clear();
+    _in_flight_bytes = 0;
+    update_count();
+}
+
+void CommandQueue::stats(uint32_t& completed, uint32_t& errors, uint32_t& timeouts, uint32_t& max_latency_ms, uint32_t& avg_latency_ms) {
+    completed      = _completed;
+    errors         = _errors;
+    timeouts       = _timeouts;
+    max_latency_ms = _max_latency;
+    avg_latency_ms = _avg_latency / 8;
+}
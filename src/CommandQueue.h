@@ -0,0 +1,86 @@
+// Copyright (c) 2024 - Mitch Bradley
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+// Outbound command queue.  send_line() adds a command and returns at once.
+// Commands are written to FluidNC as long as fewer than CMD_WINDOW of them,
+// totalling at most CMD_RX_BYTES, are awaiting a response.  FluidNC answers
+// each line in order with ok or error:N, so every response completes the
+// oldest command in flight.
+//
+// A command that is not answered within its timeout has its callback run
+// with CMD_TIMEOUT, but stays in flight as a placeholder.  FluidNC answers
+// every line eventually, so the late response is absorbed by the placeholder
+// instead of completing the next command.  The exception is a reset, after
+// which FluidNC never answers the lines it had, so a reset or restart
+// clears the queue, as does disconnect detection when the link goes quiet.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+
+// Commands that may await a response at once
+#ifndef CMD_WINDOW
+#    define CMD_WINDOW 4
+#endif
+
+// Bytes that may await a response at once; keeps within FluidNC's line buffer
+#ifndef CMD_RX_BYTES
+#    define CMD_RX_BYTES 128
+#endif
+
+// Status passed to a completion callback, besides 0 for ok and N for error:N
+const int CMD_TIMEOUT = -1;
+
+// Timeouts for send_line()
+const int CMD_TIMEOUT_MS      = 2000;   // Most commands are answered at once
+const int CMD_FILE_TIMEOUT_MS = 15000;  // SD card listings and file reads
+const int CMD_NO_TIMEOUT      = 0;      // Answered when motion ends, as $H and G38.2
+
+// Called in the UI loop with the status and the time from sending to response
+typedef std::function<void(int status, int latency_ms)> command_done_t;
+
+class CommandQueue {
+private:
+    struct command_t {
+        std::string    line;
+        int            timeout;
+        command_done_t done;
+        int            sent_ms;
+        bool           expired;  // Timed out; waiting only to absorb the response
+    };
+
+    std::deque<command_t> _waiting;    // Not yet sent
+    std::deque<command_t> _in_flight;  // Sent, awaiting ok or error
+    size_t                _in_flight_bytes = 0;
+
+    uint32_t _completed   = 0;
+    uint32_t _errors      = 0;
+    uint32_t _timeouts    = 0;
+    uint32_t _max_latency = 0;
+    uint32_t _avg_latency = 0;  // Exponential average, scaled by 8
+
+    void finish(command_t& cmd, int status);
+    void update_count();
+
+public:
+    void add(const char* line, int timeout, const command_done_t& done);
+
+    // Sends what the window allows and reports commands that were not
+    // answered in time
+    void poll();
+
+    // Called for each ok (status 0) or error:N from FluidNC
+    void complete(int status);
+
+    // Drops all commands, as when FluidNC resets
+    void clear();
+
+    void stats(uint32_t& completed, uint32_t& errors, uint32_t& timeouts, uint32_t& max_latency_ms, uint32_t& avg_latency_ms);
+};
+
+// Owned by the protocol task when there is one
+extern CommandQueue commands;
@@ -16,3 +16,22 @@
 
 // Automatically leave Homing Scene after homing is finished
 // #define AUTO_HOMING_RETURN
+
+// Subscribe to FluidNC's periodic status reports with $RI instead of
+// requesting each report, and detect disconnects from missing reports
+// #define AUTO_REPORT
+
+// Memory for pre-rendered backgrounds and icons, shared by all scenes.
+// The least recently used ones are dropped to stay within this limit.
+// The default is 160000, or 64000 on the CYD.  The CYD has no PSRAM, so
+// everything shares roughly 300 KB of internal heap:
+//   canvas          57.6 KB (76.8 KB with ALTERNATE_MF_SCENE)
+//   shadow frame    the same again, allocated at startup
+//   BG_CACHE_BYTES  64 KB
+//   glyph atlases   8 KB (GLYPH_CACHE_BYTES in Text.cpp)
+// which leaves room for the file list, JSON parsing and the UART buffers.
+// #define BG_CACHE_BYTES 160000
+
+// Time the render path and event loop, and show the results on the debug
+// port and optionally over the display.  See Profiler.h.
+// #define PROFILER
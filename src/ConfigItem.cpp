@@ -1,21 +1,83 @@
 #include "ConfigItem.h"
 #include "Scene.h"
+#include "StrHash.h"
 
-std::vector<ConfigItem*> configRequests;
+#include <unordered_map>
+#include <vector>
 
-void parse_dollar(const char* line) {
-    for (auto it = configRequests.begin(); it != configRequests.end(); ++it) {
-        auto item = *it;
+// Items awaiting a value, indexed by a hash of the name so that each
+// incoming $ line costs one lookup however many items are expected
+static std::unordered_multimap<uint32_t, ConfigItem*> configIndex;
+
+static int fetches_pending = 0;
 
-        size_t cmdlen = strlen(item->name());
+static uint32_t name_hash(ConfigItem* item) {
+    return str_hash(item->name());
+}
 
-        if (strncmp(line, item->name(), cmdlen) == 0 && line[cmdlen] == '=') {
-            line += cmdlen + 1;
-            item->got(line);
+void expect_config(ConfigItem* item) {
+    auto range = configIndex.equal_range(name_hash(item));
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second == item) {
+            return;
+        }
+    }
+    configIndex.emplace(name_hash(item), item);
+}
 
-            current_scene->reDisplay();
-            configRequests.erase(it);
-            break;
+void forget_request(ConfigItem* item) {
+    auto range = configIndex.equal_range(name_hash(item));
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second == item) {
+            configIndex.erase(it);
+            return;
         }
     }
 }
+
+void parse_dollar(const char* line) {
+    const char* eq = strchr(line, '=');
+    if (!eq) {
+        return;
+    }
+    size_t len   = eq - line;
+    auto   range = configIndex.equal_range(str_hash_n(line, len));
+    for (auto it = range.first; it != range.second; ++it) {
+        auto item = it->second;
+        if (strlen(item->name()) == len && strncmp(line, item->name(), len) == 0) {
+            item->got(eq + 1);
+            configIndex.erase(it);
+            // A batch redraws once when it completes
+            if (!fetches_pending) {
+                request_redraw();
+            }
+            return;
+        }
+    }
+}
+
+void fetch_config(const char* path) {
+    ++fetches_pending;
+    std::string prefix(path);
+    prefix += '/';
+    send_line(path, 5000, [prefix](int, int) {
+        if (fetches_pending) {  // Not if reset_config_requests() came first
+            --fetches_pending;
+        }
+        std::vector<ConfigItem*> missing;
+        for (auto& entry : configIndex) {
+            if (strncmp(entry.second->name(), prefix.c_str(), prefix.length()) == 0) {
+                missing.push_back(entry.second);
+            }
+        }
+        for (auto item : missing) {
+            item->init();
+        }
+        request_redraw();
+    });
+}
+
+void reset_config_requests() {
+    configIndex.clear();
+    fetches_pending = 0;
+}
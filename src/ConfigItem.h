@@ -1,10 +1,10 @@
-#include <vector>
 #include <string>
 #include <cstring>
 #include "FluidNCModel.h"
 
 class ConfigItem;
-extern std::vector<ConfigItem*> configRequests;
+void expect_config(ConfigItem* item);
+void forget_request(ConfigItem* item);
 
 class ConfigItem {
 private:
@@ -17,10 +17,22 @@ public:
     virtual void set(const char* s) = 0;
     const char*  name() { return _name; }
     bool         known() { return _known; }
-    void         init() {
+    // Waits for the value without requesting it, for use with fetch_config()
+    void expect() {
         _known = false;
-        configRequests.push_back(this);
-        send_line(_name);
+        expect_config(this);
+    }
+    // Requests the value on its own
+    void init() {
+        expect();
+        // A setting that FluidNC does not have is answered with an error
+        // instead of a value, so stop waiting for it
+        ConfigItem* item = this;
+        send_line(_name, CMD_TIMEOUT_MS, [item](int status, int) {
+            if (status) {
+                forget_request(item);
+            }
+        });
     }
     void got(const char* s) {
         _known = true;
@@ -69,3 +81,12 @@ public:
 };
 
 void parse_dollar(const char* line);
+
+// Requests every setting under path, e.g. "$/axes", with one command.  Items
+// that were expected under path and are missing from the reply are then
+// requested one by one.
+void fetch_config(const char* path);
+
+// Forgets outstanding requests, whose answers will not come, as when
+// FluidNC disconnects.  The items are requested again on reconnection.
+void reset_config_requests();
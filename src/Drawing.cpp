@@ -4,14 +4,95 @@
 #include "System.h"
 #include "Drawing.h"
 #include "alarm.h"
+#include "Profiler.h"
 #include <map>
+#include <vector>
+
+#ifdef ARDUINO
+#    include <esp_heap_caps.h>
+#endif
+
+// Damage tracking.  The drawing helpers record the canvas regions that
+// they touch, and refreshDisplay() compares those regions against a
+// shadow copy of the last frame that was pushed, sending only the tiles
+// that actually changed.  Code that draws on the canvas directly, without
+// going through these helpers, must call markDirty() itself.
+static const int TILE_SIZE = 16;
+
+// Empty when _dirty_left >= _dirty_right
+static int _dirty_left   = 0;
+static int _dirty_top    = 0;
+static int _dirty_right  = 0;
+static int _dirty_bottom = 0;
+
+static uint8_t* _shadow        = nullptr;
+static bool     _shadow_failed = false;  // Not enough memory for a shadow frame
+static bool     _display_valid = false;  // The panel shows the last pushed frame
+
+bool allDirty() {
+    return _dirty_left == 0 && _dirty_top == 0 && _dirty_right == canvas.width() && _dirty_bottom == canvas.height();
+}
+
+void markDirty(int x, int y, int width, int height) {
+    int right  = x + width;
+    int bottom = y + height;
+    if (x < 0) {
+        x = 0;
+    }
+    if (y < 0) {
+        y = 0;
+    }
+    if (right > canvas.width()) {
+        right = canvas.width();
+    }
+    if (bottom > canvas.height()) {
+        bottom = canvas.height();
+    }
+    if (x >= right || y >= bottom) {
+        return;
+    }
+    if (_dirty_left >= _dirty_right) {
+        _dirty_left   = x;
+        _dirty_top    = y;
+        _dirty_right  = right;
+        _dirty_bottom = bottom;
+        return;
+    }
+    if (x < _dirty_left) {
+        _dirty_left = x;
+    }
+    if (y < _dirty_top) {
+        _dirty_top = y;
+    }
+    if (right > _dirty_right) {
+        _dirty_right = right;
+    }
+    if (bottom > _dirty_bottom) {
+        _dirty_bottom = bottom;
+    }
+}
+
+void markAllDirty() {
+    markDirty(0, 0, canvas.width(), canvas.height());
+}
+
+void invalidateDisplay() {
+    _display_valid = false;
+    markAllDirty();
+}
+
+static void markCircle(int x, int y, int radius) {
+    markDirty(x - radius, y - radius, radius * 2 + 1, radius * 2 + 1);
+}
 
 void drawBackground(int color) {
     canvas.fillSprite(color);
+    markAllDirty();
 }
 
 void drawFilledCircle(int x, int y, int radius, int fillcolor) {
     canvas.fillCircle(x, y, radius, fillcolor);
+    markCircle(x, y, radius);
 }
 void drawFilledCircle(Point xy, int radius, int fillcolor) {
     Point dispxy = xy.to_display();
@@ -22,6 +103,7 @@ void drawCircle(int x, int y, int radius, int thickness, int outlinecolor) {
     for (int i = 0; i < thickness; i++) {
         canvas.drawCircle(x, y, radius - i, outlinecolor);
     }
+    markCircle(x, y, radius);
 }
 void drawCircle(Point xy, int radius, int thickness, int outlinecolor) {
     Point dispxy = xy.to_display();
@@ -31,6 +113,7 @@ void drawCircle(Point xy, int radius, int thickness, int outlinecolor) {
 void drawOutlinedCircle(int x, int y, int radius, int fillcolor, int outlinecolor) {
     canvas.fillCircle(x, y, radius, fillcolor);
     canvas.drawCircle(x, y, radius, outlinecolor);
+    markCircle(x, y, radius);
 }
 void drawOutlinedCircle(Point xy, int radius, int fillcolor, int outlinecolor) {
     Point dispxy = xy.to_display();
@@ -39,6 +122,7 @@ void drawOutlinedCircle(Point xy, int radius, int fillcolor, int outlinecolor) {
 
 void drawRect(int x, int y, int width, int height, int radius, int bgcolor) {
     canvas.fillRoundRect(x, y, width, height, radius, bgcolor);
+    markDirty(x, y, width, height);
 }
 void drawRect(Point xy, int width, int height, int radius, int bgcolor) {
     Point offsetxy = { width / 2, -height / 2 };    // { 30, -30}
@@ -52,6 +136,7 @@ void drawRect(Point xy, Point wh, int radius, int bgcolor) {
 void drawOutlinedRect(int x, int y, int width, int height, int bgcolor, int outlinecolor) {
     canvas.fillRoundRect(x, y, width, height, 5, bgcolor);
     canvas.drawRoundRect(x, y, width, height, 5, outlinecolor);
+    markDirty(x, y, width, height);
 }
 void drawOutlinedRect(Point xy, int width, int height, int bgcolor, int outlinecolor) {
     Point dispxy = xy.to_display();
@@ -61,26 +146,142 @@ void drawPngFile(const char* filename, Point xy) {
     //    drawPngFile(filename, xo(xy.x), yo(xy.y));
     //    drawPngFile(filename, xy.x - 40, xy.y);
     drawPngFile(filename, xy.x, xy.y);
+    markAllDirty();
 }
 void drawPngBackground(const char* filename) {
-    drawPngFile(filename, 0, 0);
+    LGFX_Sprite* sprite = getPngBackground(filename, canvas.width(), canvas.height());
+    if (sprite) {
+        drawBackground(sprite);
+    } else {
+        PROFILE_SCOPE(PROF_PNG);
+        drawPngFile(filename, 0, 0);
+        markAllDirty();
+    }
 }
 void drawBackground(LGFX_Sprite* sprite, int x, int y) {
     sprite->pushSprite(x, y);
+    markDirty(x, y, sprite->width(), sprite->height());
+}
+
+// Background cache.  Pre-rendered backgrounds and icons are kept in a
+// pool of sprites shared by all scenes, keyed by name and size, so a PNG
+// is inflated once instead of on every scene entry.  The least recently
+// used entries are dropped when the pool exceeds BG_CACHE_BYTES or when
+// the heap is too tight for a new sprite.
+#ifndef BG_CACHE_BYTES
+#    ifdef USE_LOVYANGFX
+#        define BG_CACHE_BYTES 64000  // The CYD has no PSRAM; see Config.h
+#    else
+#        define BG_CACHE_BYTES 160000
+#    endif
+#endif
+#ifndef BG_HEAP_RESERVE
+#    define BG_HEAP_RESERVE 16384  // Leave this much contiguous heap for everyone else
+#endif
+
+struct bg_entry_t {
+    std::string  name;
+    int          width;
+    int          height;
+    size_t       bytes;
+    uint32_t     last_used;
+    LGFX_Sprite* sprite;
+};
+static std::vector<bg_entry_t> bg_cache;
+static size_t                  bg_bytes = 0;
+static uint32_t                bg_clock = 0;
+
+static int bg_hits      = 0;
+static int bg_misses    = 0;
+static int bg_evictions = 0;
+
+static bool evictBackground() {
+    if (bg_cache.empty()) {
+        return false;
+    }
+    auto lru = bg_cache.begin();
+    for (auto it = bg_cache.begin(); it != bg_cache.end(); ++it) {
+        if (it->last_used < lru->last_used) {
+            lru = it;
+        }
+    }
+    lru->sprite->deleteSprite();
+    delete lru->sprite;
+    bg_bytes -= lru->bytes;
+    bg_cache.erase(lru);
+    ++bg_evictions;
+    return true;
 }
 
-LGFX_Sprite* createPngBackground(const char* filename) {
+#ifdef ARDUINO
+static bool heapTight(size_t bytes) {
+    return heap_caps_get_largest_free_block(MALLOC_CAP_8BIT) < bytes + BG_HEAP_RESERVE;
+}
+#else
+static bool heapTight(size_t) {
+    return false;
+}
+#endif
+
+LGFX_Sprite* getBackground(const char* name, int width, int height, bg_renderer_t render) {
+    for (auto& entry : bg_cache) {
+        if (entry.width == width && entry.height == height && entry.name == name) {
+            entry.last_used = ++bg_clock;
+            ++bg_hits;
+            return entry.sprite;
+        }
+    }
+    ++bg_misses;
+
+    size_t bytes = (size_t)width * height * canvas.getColorDepth() / 8;
+    while (bg_bytes + bytes > BG_CACHE_BYTES || heapTight(bytes)) {
+        if (!evictBackground()) {
+            break;
+        }
+    }
+
     LGFX_Sprite* sprite = new LGFX_Sprite(&canvas);
     sprite->setColorDepth(canvas.getColorDepth());
-    #ifdef ALTERNATE_MF_SCENE
-        sprite->createSprite(240,256);
-    #else
-        sprite->createSprite(canvas.width(), canvas.height());
-    #endif
-    drawPngFile(sprite, filename, 0, 0);
+    while (!sprite->createSprite(width, height)) {
+        if (!evictBackground()) {
+            delete sprite;
+            return nullptr;
+        }
+    }
+    render(sprite, name);
+    bg_cache.push_back({ name, width, height, bytes, ++bg_clock, sprite });
+    bg_bytes += bytes;
     return sprite;
 }
 
+static void renderPng(LGFX_Sprite* sprite, const char* filename) {
+    PROFILE_SCOPE(PROF_PNG);
+    drawPngFile(sprite, filename, 0, 0);
+}
+
+LGFX_Sprite* getPngBackground(const char* filename, int width, int height) {
+    if (width == 0) {
+#ifdef ALTERNATE_MF_SCENE
+        width  = 240;
+        height = 256;
+#else
+        width  = canvas.width();
+        height = canvas.height();
+#endif
+    }
+    return getBackground(filename, width, height, renderPng);
+}
+
+void purgeBackgrounds() {
+    while (evictBackground()) {}
+}
+
+void backgroundCacheStats(int& hits, int& misses, int& evictions) {
+    hits      = bg_hits;
+    misses    = bg_misses;
+    evictions = bg_evictions;
+}
+
 // We use 1 to mean no background
 // 1 is visually indistinguishable from black so losing that value is unimportant
 #define NO_BG 1
@@ -126,6 +327,7 @@ void drawStatus() {
     int bgColor = stateBGColors[state];
     if (bgColor != 1) {
         canvas.fillRoundRect(0, y, width, height, 5, bgColor);
+        markDirty(0, y, width, height);
     }
     int fgColor = stateFGColors[state];
     if (state == Alarm) {
@@ -147,6 +349,7 @@ void drawStatusTiny(int y) {
     int bgColor = stateBGColors[state];
     if (bgColor != 1) {
         canvas.fillRoundRect((display_short_side() - width) / 2, y, width, height, 5, bgColor);
+        markDirty((display_short_side() - width) / 2, y, width, height);
     }
     centered_text(my_state_string, y + height / 2 + 3, stateFGColors[state], TINY);
 }
@@ -158,6 +361,7 @@ void drawStatusSmall(int y) {
     int bgColor = stateBGColors[state];
     if (bgColor != 1) {
         canvas.fillRoundRect((display_short_side() - width) / 2, y, width, height, 5, bgColor);
+        markDirty((display_short_side() - width) / 2, y, width, height);
     }
     centered_text(my_state_string, y + height / 2 + 3, stateFGColors[state], SMALL);
 }
@@ -256,26 +460,26 @@ void fancyNumber(pos_t n, int n_decimals, int hl_digit, int x, int y, int text_c
 }
 
 void DRO::drawHoming(int axis, bool highlight, bool homed) {
-    text(axisNumToCStr(axis), text_left_x(), text_middle_y(), myLimitSwitches[axis] ? GREEN : YELLOW, MEDIUM, middle_left);
-    fancyNumber(myAxes[axis], num_digits(), -1, text_right_x(), text_middle_y(), highlight ? (homed ? GREEN : RED) : DARKGREY, RED);
+    text(axisNumToCStr(axis), text_left_x(), text_middle_y(), machine.limits[axis] ? GREEN : YELLOW, MEDIUM, middle_left);
+    fancyNumber(machine.axes[axis], num_digits(), -1, text_right_x(), text_middle_y(), highlight ? (homed ? GREEN : RED) : DARKGREY, RED);
     advance();
 }
 
 void DRO::draw(int axis, int hl_digit, bool highlight) {
     text(axisNumToCStr(axis), text_left_x(), text_middle_y(), highlight ? GREEN : DARKGREY, MEDIUM, middle_left);
     fancyNumber(
-        myAxes[axis], num_digits(), hl_digit, text_right_x(), text_middle_y(), highlight ? WHITE : DARKGREY, highlight ? RED : DARKGREY);
+        machine.axes[axis], num_digits(), hl_digit, text_right_x(), text_middle_y(), highlight ? WHITE : DARKGREY, highlight ? RED : DARKGREY);
     advance();
 }
 
 void DRO::draw(int axis_x, int axis_y, int digits_x, int digits_y, int axis, int hl_digit, bool highlight){
     text(axisNumToCStr(axis), axis_x, axis_y, highlight ? GREEN : WHITE, SMALL, middle_center);
     fancyNumber(
-        myAxes[axis], num_digits(), hl_digit, digits_x, digits_y, WHITE, WHITE, TINY);
+        machine.axes[axis], num_digits(), hl_digit, digits_x, digits_y, WHITE, WHITE, TINY);
 }
 
 void DRO::draw(int axis, bool highlight) {
-    Stripe::draw(axisNumToChar(axis), pos_to_cstr(myAxes[axis], num_digits()), highlight, myLimitSwitches[axis] ? GREEN : WHITE);
+    Stripe::draw(axisNumToChar(axis), pos_to_cstr(machine.axes[axis], num_digits()), highlight, machine.limits[axis] ? GREEN : WHITE);
 }
 
 void LED::draw(bool highlighted) {
@@ -295,6 +499,8 @@ void drawLockIcons(bool locked) {
         canvas.fillRect(0,0,16,16,BLACK);
         canvas.fillRect(223,0,16,16,BLACK);
     }
+    markDirty(0, 0, 17, 17);
+    markDirty(223, 0, 17, 17);
 }
 extern bool last_locked;
 #endif
@@ -307,16 +513,118 @@ void drawMenuTitle(const char* name) {
 #endif
 }
 
+// Allocates the shadow frame, a full copy of the canvas.  init_system()
+// calls this right after creating the canvas, while the heap still has a
+// contiguous block that large, before the background and glyph caches
+// take their share.  The tile comparison works on whole bytes, so low
+// color depths do without a shadow and just push the dirty rectangle.
+void initShadow() {
+    int depth = canvas.getColorDepth();
+    if (_shadow || _shadow_failed || (depth & 7) != 0) {
+        return;
+    }
+    _shadow        = (uint8_t*)malloc(canvas.width() * (depth / 8) * canvas.height());
+    _shadow_failed = !_shadow;
+    _display_valid = false;
+}
+
+// Sends one rectangle of the canvas to the panel
+static void pushRect(int x, int y, int width, int height) {
+    display.setClipRect(sprite_offset.x + x, sprite_offset.y + y, width, height);
+    canvas.pushSprite(sprite_offset.x, sprite_offset.y);
+    display.clearClipRect();
+}
+
 void refreshDisplay() {
+    if (_dirty_left >= _dirty_right) {
+        return;  // Nothing has been drawn since the last push
+    }
+#ifdef PROFILER
+    if (profile_overlay_enabled()) {
+        profile_draw_overlay();
+    }
+#endif
+    PROFILE_SCOPE(PROF_PUSH);
+
+    int    width  = canvas.width();
+    int    height = canvas.height();
+    int    depth  = canvas.getColorDepth();
+    size_t bpp    = depth / 8;
+    size_t stride = width * bpp;
+
+    initShadow();
+
     display.startWrite();
-    canvas.pushSprite(sprite_offset.x, sprite_offset.y);
+    if (!_display_valid) {
+        canvas.pushSprite(sprite_offset.x, sprite_offset.y);
+        if (_shadow) {
+            memcpy(_shadow, canvas.getBuffer(), stride * height);
+        }
+        _display_valid = true;
+    } else if (!_shadow) {
+        pushRect(_dirty_left, _dirty_top, _dirty_right - _dirty_left, _dirty_bottom - _dirty_top);
+    } else {
+        const uint8_t* frame = (const uint8_t*)canvas.getBuffer();
+
+        // Changed tiles are collected as one span of columns per row of
+        // tiles, and consecutive rows with the same span are sent together.
+        int span_left = 0, span_right = 0, span_top = 0, span_bottom = 0;
+
+        int first_col = _dirty_left / TILE_SIZE;
+        int last_col  = (_dirty_right - 1) / TILE_SIZE;
+        for (int ty = _dirty_top / TILE_SIZE * TILE_SIZE; ty < _dirty_bottom; ty += TILE_SIZE) {
+            int rows  = (ty + TILE_SIZE > height) ? height - ty : TILE_SIZE;
+            int left  = width;
+            int right = 0;
+            for (int col = first_col; col <= last_col; col++) {
+                int    tx     = col * TILE_SIZE;
+                size_t offset = ty * stride + tx * bpp;
+                size_t len    = ((tx + TILE_SIZE > width) ? width - tx : TILE_SIZE) * bpp;
+                int    row    = 0;
+                while (row < rows && memcmp(frame + offset + row * stride, _shadow + offset + row * stride, len) == 0) {
+                    ++row;
+                }
+                if (row == rows) {
+                    continue;  // Unchanged tile
+                }
+                for (; row < rows; ++row) {
+                    memcpy(_shadow + offset + row * stride, frame + offset + row * stride, len);
+                }
+                if (tx < left) {
+                    left = tx;
+                }
+                right = tx + len / bpp;
+            }
+            if (left == span_left && right == span_right && span_bottom == ty) {
+                span_bottom = ty + rows;  // Extend the span downward
+                continue;
+            }
+            if (span_left < span_right) {
+                pushRect(span_left, span_top, span_right - span_left, span_bottom - span_top);
+            }
+            if (left < right) {
+                span_left   = left;
+                span_right  = right;
+                span_top    = ty;
+                span_bottom = ty + rows;
+            } else {
+                span_left = span_right = 0;
+            }
+        }
+        if (span_left < span_right) {
+            pushRect(span_left, span_top, span_right - span_left, span_bottom - span_top);
+        }
+    }
     display.endWrite();
+
+    _dirty_left = _dirty_right = 0;
 }
 
 void drawError() {
     if (lastError) {
         if ((milliseconds() - errorExpire) < 0) {
             canvas.fillCircle(120, 120, 95, RED);
+            markCircle(120, 120, 95);
             drawCircle(120, 120, 95, 5, WHITE);
             centered_text("Error", 95, WHITE, MEDIUM);
             centered_text(decode_error_number(lastError), 140, WHITE, TINY);
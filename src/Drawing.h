@@ -58,7 +58,16 @@ public:
 // Routines that take Point as an argument work in a coordinate
 // space where 0,0 is at the center of the display and +Y is up
 
-LGFX_Sprite* createPngBackground(const char* filename);
+// Cached pre-rendered backgrounds and icons, shared by all scenes.  The
+// returned sprite belongs to the cache and may be freed by a later call,
+// so fetch it each time it is drawn rather than keeping the pointer.
+// A width of 0 means the size of a full background.  Returns nullptr if
+// there is not enough memory even after evicting everything else.
+typedef void (*bg_renderer_t)(LGFX_Sprite* sprite, const char* name);
+LGFX_Sprite* getBackground(const char* name, int width, int height, bg_renderer_t render);
+LGFX_Sprite* getPngBackground(const char* filename, int width = 0, int height = 0);
+void         purgeBackgrounds();
+void         backgroundCacheStats(int& hits, int& misses, int& evictions);
 
 void drawBackground(LGFX_Sprite* sprite, int x=0, int y=0);
 void drawBackground(int color);
@@ -89,6 +98,15 @@ void drawMenuTitle(const char* name);
 void drawPngFile(const char* filename, Point xy);
 void drawPngBackground(const char* filename);
 
+// Damage tracking for refreshDisplay().  markDirty() records a canvas
+// region that has been drawn, for code that draws on the canvas directly.
+// invalidateDisplay() forces a full push, e.g. after the panel rotates.
+void markDirty(int x, int y, int width, int height);
+void markAllDirty();
+bool allDirty();
+void invalidateDisplay();
+void initShadow();
+
 void refreshDisplay();
 
 void drawError();
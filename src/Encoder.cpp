@@ -3,6 +3,32 @@
 #include "sdkconfig.h"
 #include "driver/pcnt.h"
 #include "driver/gpio.h"
+#include "esp_timer.h"
+#include "InputQueue.h"
+
+// The counter runs between these limits, where it wraps to 0 and raises an
+// interrupt.  The handler folds the wrap into enc_base and queues an event.
+#define ENC_LIMIT 4
+
+static volatile int16_t enc_base = 0;
+
+static void IRAM_ATTR encoder_isr(void* arg) {
+    uint32_t status;
+    pcnt_get_event_status(PCNT_UNIT_0, &status);
+    if (status & PCNT_EVT_H_LIM) {
+        enc_base += ENC_LIMIT;
+    } else if (status & PCNT_EVT_L_LIM) {
+        enc_base -= ENC_LIMIT;
+    } else {
+        return;
+    }
+    input_event_t event;
+    event.ms     = esp_timer_get_time() / 1000;
+    event.value  = enc_base;
+    event.button = 0;
+    event.type   = ENCODER_EVENT;
+    encoder_events.push(event);
+}
 
 /* clang-format: off */
 void init_encoder(int a_pin, int b_pin) {
@@ -15,8 +41,8 @@ void init_encoder(int a_pin, int b_pin) {
         .pos_mode   = PCNT_COUNT_INC,     // Count Only On Rising-Edges
         .neg_mode   = PCNT_COUNT_DEC,     // Discard Falling-Edge
 
-        .counter_h_lim = INT16_MAX,
-        .counter_l_lim = INT16_MIN,
+        .counter_h_lim = ENC_LIMIT,
+        .counter_l_lim = -ENC_LIMIT,
 
         .unit    = PCNT_UNIT_0,
         .channel = PCNT_CHANNEL_0,
@@ -39,11 +65,21 @@ void init_encoder(int a_pin, int b_pin) {
 
     pcnt_counter_pause(PCNT_UNIT_0);  // Initial PCNT init
     pcnt_counter_clear(PCNT_UNIT_0);
+
+    pcnt_event_enable(PCNT_UNIT_0, PCNT_EVT_H_LIM);
+    pcnt_event_enable(PCNT_UNIT_0, PCNT_EVT_L_LIM);
+    pcnt_isr_service_install(0);
+    pcnt_isr_handler_add(PCNT_UNIT_0, encoder_isr, nullptr);
+
     pcnt_counter_resume(PCNT_UNIT_0);
 }
 
+// Counts that have not reached a limit yet are only seen by polling
 int16_t get_encoder() {
-    int16_t count;
-    pcnt_get_counter_value(PCNT_UNIT_0, &count);
-    return count;
+    int16_t base, count;
+    do {
+        base = enc_base;
+        pcnt_get_counter_value(PCNT_UNIT_0, &count);
+    } while (base != enc_base);  // Retry if the counter wrapped meanwhile
+    return base + count;
 }
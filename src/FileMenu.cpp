@@ -70,7 +70,7 @@ void FileMenu::onRedButtonPress() {
 }
 void FileMenu::onFilesList() {
     _selected = 0;
-    reDisplay();
+    request_redraw();
 }
 
 void FileMenu::onDialButtonPress() {
@@ -152,7 +152,7 @@ void FileMenu::rotate(int delta) {
         _selected = num_items() - 1;
     }
     _items[_selected]->highlight();
-    reDisplay();
+    request_redraw();
 }
 
 int FileMenu::touchedItem(int x, int y) {
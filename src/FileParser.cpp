@@ -3,42 +3,177 @@
 
 #include "FileParser.h"
 
-#include "Scene.h"  // current_scene->reDisplay()
+#include "Scene.h"  // request_redraw()
 #include "Menu.h"
 #include "GrblParserC.h"  // send_line()
 #include "HomingScene.h"  // set_axis_homed()
 
-#include <JsonStreamingParser.h>
-#include <JsonListener.h>
+#include "JsonScanner.h"
+#include "ProtocolTask.h"  // run_on_ui()
+#include "StrHash.h"
+#include "Profiler.h"
 
 #include "MacroItem.h"
 
+#include <algorithm>
+#include <cstring>
+
 extern Menu macroMenu;
 
-fileinfo              fileInfo;
-std::vector<fileinfo> fileVector;
+FileIndex fileIndex;
+
+static_assert(FILE_INDEX_BYTES <= 65536, "FileIndex arena offsets are 16 bits");
 
-JsonStreamingParser parser;
+JsonScanner parser;
 
-// This is necessary because of an annoying "feature" of JsonStreamingParser.
-// After it issues an endDocument, it sets its internal state to STATE_DONE,
-// in which it ignores everything.  You cannot reset the parser in the endDocument
-// handler because it sets that state afterwards.  So we have to record the fact
-// that an endDocument has happened and do the reset later, when new data comes in.
+// After the parser issues an endDocument, it ignores everything until it
+// is reset.  You cannot reset the parser in the endDocument handler because
+// the rest of that message must still be ignored.  So we have to record the
+// fact that an endDocument has happened and do the reset later, when new
+// data comes in.
 bool parser_needs_reset = true;
 
-static bool fileinfoCompare(const fileinfo& f1, const fileinfo& f2) {
+bool FileIndex::less(const char* name1, int size1, const char* name2, int size2) const {
     // sort into filename order, with files first and folders second (same as on webUI)
-    if (!f1.isDir() && f2.isDir()) {
-        return true;
+    bool dir1 = size1 < 0;
+    bool dir2 = size2 < 0;
+    if (dir1 != dir2) {
+        return dir2;
     }
-    if (f1.isDir() && !f2.isDir()) {
-        return false;
+    return strcmp(name1, name2) < 0;
+}
+
+void FileIndex::clear() {
+    _used        = 0;
+    _dead        = 0;
+    _count       = 0;
+    _truncated   = false;
+    _below        = 0;
+    _total_below  = 0;
+    _total        = 0;
+    _have_floor   = false;
+    _have_ceiling = false;
+}
+
+void FileIndex::setAnchor(const char* name, int size) {
+    _anchor      = AROUND;
+    _anchor_name = name;
+    _anchor_size = size;
+}
+
+size_t FileIndex::anchorIndex() const {
+    if (_anchor == LAST) {
+        return _count ? _count - 1 : 0;
     }
-    if (f1.fileName.compare(f2.fileName) < 0) {
-        return true;
+    return (_below < _count) ? _below : (_count ? _count - 1 : 0);
+}
+
+// Dropped entries leave their names behind in the arena.  Squeeze them
+// out by moving the live names down in arena order.
+void FileIndex::compact() {
+    static uint16_t order[FILE_INDEX_ENTRIES];
+    for (size_t i = 0; i < _count; i++) {
+        order[i] = i;
+    }
+    std::sort(order, order + _count, [this](uint16_t a, uint16_t b) { return _entries[a].offset < _entries[b].offset; });
+    size_t used = 0;
+    for (size_t i = 0; i < _count; i++) {
+        entry_t& entry = _entries[order[i]];
+        size_t   len   = strlen(&_arena[entry.offset]) + 1;
+        memmove(&_arena[used], &_arena[entry.offset], len);
+        entry.offset = used;
+        used += len;
+    }
+    _used = used;
+    _dead = 0;
+}
+
+void FileIndex::drop_first() {
+    _dead += strlen(name(0)) + 1;
+    _floor_name = name(0);
+    _floor_size = _entries[0].size;
+    _have_floor = true;
+    memmove(&_entries[0], &_entries[1], (_count - 1) * sizeof(entry_t));
+    --_count;
+    --_below;
+    _truncated = true;
+}
+
+void FileIndex::drop_last() {
+    _dead += strlen(name(_count - 1)) + 1;
+    _ceiling_name = name(_count - 1);
+    _ceiling_size = _entries[_count - 1].size;
+    _have_ceiling = true;
+    --_count;
+    _truncated = true;
+}
+
+void FileIndex::add(const char* name, int size) {
+    bool below = _anchor == LAST || (_anchor == AROUND && less(name, size, _anchor_name.c_str(), _anchor_size));
+    ++_total;
+    if (below) {
+        ++_total_below;
+    }
+
+    size_t len = strlen(name) + 1;
+    if (len > sizeof(_arena)) {
+        _truncated = true;
+        return;
+    }
+    if ((_have_floor && !less(_floor_name.c_str(), _floor_size, name, size)) ||
+        (_have_ceiling && !less(name, size, _ceiling_name.c_str(), _ceiling_size))) {
+        return;
+    }
+
+    // Binary search for the insertion point
+    size_t lo = 0;
+    size_t hi = _count;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (less(this->name(mid), _entries[mid].size, name, size)) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    // Reclaim the names of earlier drops before dropping anything more
+    if (_used + len > sizeof(_arena) && _dead) {
+        compact();
+    }
+
+    // When full, trim whichever side of the anchor is over its share,
+    // or drop the new entry if it would be the one trimmed
+    size_t below_share = _anchor == LAST ? FILE_INDEX_ENTRIES : _anchor == AROUND ? FILE_INDEX_ENTRIES / 2 : 0;
+    while (_count == FILE_INDEX_ENTRIES || _used + len > sizeof(_arena)) {
+        if (_below > below_share || _below == _count) {
+            if (lo == 0) {
+                _truncated = true;
+                return;
+            }
+            drop_first();
+            --lo;
+        } else {
+            if (lo == _count) {
+                _truncated = true;
+                return;
+            }
+            drop_last();
+        }
+        if (_used + len > sizeof(_arena)) {
+            compact();
+        }
+    }
+
+    memcpy(&_arena[_used], name, len);
+    memmove(&_entries[lo + 1], &_entries[lo], (_count - lo) * sizeof(entry_t));
+    _entries[lo].offset = _used;
+    _entries[lo].size   = size;
+    _used += len;
+    ++_count;
+    if (below) {
+        ++_below;
     }
-    return false;
 }
 
 int fileFirstLine = 0;
@@ -49,46 +184,59 @@ extern JsonListener* pInitialListener;
 
 class FilesListListener : public JsonListener {
 private:
-    bool        haveNewFile;
-    std::string current_key;
+    bool haveNewFile;
+
+    // The name arrives before the size, and both are needed to place the entry
+    std::string _name;
+    int         _size;
+
+    // Key strings live in the parser's buffer only until the callback returns
+    typedef enum {
+        OTHER,
+        NAME,
+        SIZE,
+    } key_t;
+    key_t _key = OTHER;
 
 public:
     void whitespace(char c) override {}
 
     void startDocument() override {}
     void startArray() override {
-        fileVector.clear();
+        fileIndex.clear();
         haveNewFile = false;
     }
     void startObject() override {}
 
     void key(const char* key) override {
-        current_key = key;
+        _key = OTHER;
         if (strcmp(key, "name") == 0) {
+            _key        = NAME;
             haveNewFile = true;  // gets reset in endObject()
+        } else if (strcmp(key, "size") == 0) {
+            _key = SIZE;
         }
     }
 
     void value(const char* value) override {
-        if (current_key == "name") {
-            fileInfo.fileName = value;
+        if (_key == NAME) {
+            _name = value;
+            _size = 0;
             return;
         }
-        if (current_key == "size") {
-            fileInfo.fileSize = atoi(value);
-            //            fileInfo.isDir    = fileInfo.fileSize < 0;
+        if (_key == SIZE) {
+            _size = atoi(value);
         }
     }
 
     void endArray() override {
-        std::sort(fileVector.begin(), fileVector.end(), fileinfoCompare);
         current_scene->onFilesList();
         parser.setListener(pInitialListener);
     }
 
     void endObject() override {
         if (haveNewFile) {
-            fileVector.push_back(fileInfo);
+            fileIndex.add(_name.c_str(), _size);
             haveNewFile = false;
         }
     }
@@ -96,9 +244,15 @@ public:
     //#define DEBUG_FILE_LIST
     void endDocument() override {
 #ifdef DEBUG_FILE_LIST
-        int ix = 0;
-        for (auto const& vi : fileVector) {
-            dbg_printf("[%d] type: %s:\"%s\", size: %d\r\n", ix++, (vi.isDir()) ? "file" : "dir ", vi.fileName.c_str(), vi.fileSize);
+        for (size_t ix = 0; ix < fileIndex.size(); ix++) {
+            dbg_printf("[%d] type: %s:\"%s\", size: %d\r\n",
+                       ix,
+                       fileIndex.isDir(ix) ? "dir " : "file",
+                       fileIndex.name(ix),
+                       fileIndex.fileSize(ix));
+        }
+        if (fileIndex.truncated()) {
+            dbg_println("File list truncated");
         }
 #endif
         init_listener();
@@ -239,7 +393,6 @@ private:
     std::string _name;
     std::string _filename;
     std::string _target;
-    std::string _key;
 
     int  _level             = 0;
     bool _in_macros_section = false;
@@ -262,7 +415,6 @@ public:
 
     void startObject() override { ++_level; }
     void key(const char* key) override {
-        _key = key;
         if (_level < 2) {
             // The only thing we care about is the macros section at level 2
             return;
@@ -319,12 +471,12 @@ public:
     void endDocument() override {}
 } preferencesListener;
 
-JsonStreamingParser* macro_parser;
+JsonScanner* macro_parser;
 
 bool reading_macros = false;
 
 void request_json_file(const char* name) {
-    send_linef("$File/SendJSON=/%s", name);
+    send_linef_timeout(CMD_FILE_TIMEOUT_MS, "$File/SendJSON=/%s", name);
     parser_needs_reset = true;
 }
 
@@ -356,15 +508,14 @@ void request_macros() {
 }
 
 void init_macro_parser() {
-    macro_parser = new JsonStreamingParser();
+    macro_parser = new JsonScanner();
     macro_parser->setListener(&macroLinesListener);
 }
 
 void macro_parser_parse_line(const char* line) {
-    char c;
-    while ((c = *line++) != '\0') {
-        macro_parser->parse(c);
-    }
+    // The scanner decodes in place, so it needs a copy it can write to
+    std::string buf(line);
+    macro_parser->parse(&buf[0]);
 }
 
 class FileLinesListener : public JsonListener {
@@ -508,42 +659,50 @@ public:
     void startObject() override {}
 
     void key(const char* key) override {
-        // Keys whose value is handled by a different listener
-        if (strcmp(key, "files") == 0) {
-            parser.setListener(&filesListListener);
-            return;
-        }
-        if (strcmp(key, "file_lines") == 0) {
-            parser.setListener(&fileLinesListener);
-            return;
-        }
-        if (strcmp(key, "result") == 0) {
-            if (_file_listener) {
-                parser.setListener(_file_listener);
-            }
-            return;
-        }
+        switch (str_hash(key)) {
+            // Keys whose value is handled by a different listener
+            case str_hash("files"):
+                if (str_is(key, "files")) {
+                    parser.setListener(&filesListListener);
+                }
+                break;
+            case str_hash("file_lines"):
+                if (str_is(key, "file_lines")) {
+                    parser.setListener(&fileLinesListener);
+                }
+                break;
+            case str_hash("result"):
+                if (str_is(key, "result") && _file_listener) {
+                    parser.setListener(_file_listener);
+                }
+                break;
 
-        // Keys where we must wait for the value
-        if (strcmp(key, "path") == 0) {
-            _key = PATH;
-            return;
-        }
-        if (strcmp(key, "cmd") == 0) {
-            _key = CMD;
-            return;
-        }
-        if (strcmp(key, "argument") == 0) {
-            _key = ARGUMENT;
-            return;
-        }
-        if (strcmp(key, "status") == 0) {
-            _key = STATUS;
-            return;
-        }
-        if (strcmp(key, "error") == 0) {
-            _key = ERROR;
-            return;
+            // Keys where we must wait for the value
+            case str_hash("path"):
+                if (str_is(key, "path")) {
+                    _key = PATH;
+                }
+                break;
+            case str_hash("cmd"):
+                if (str_is(key, "cmd")) {
+                    _key = CMD;
+                }
+                break;
+            case str_hash("argument"):
+                if (str_is(key, "argument")) {
+                    _key = ARGUMENT;
+                }
+                break;
+            case str_hash("status"):
+                if (str_is(key, "status")) {
+                    _key = STATUS;
+                }
+                break;
+            case str_hash("error"):
+                if (str_is(key, "error")) {
+                    _key = ERROR;
+                }
+                break;
         }
     }
 } initialListener;
@@ -555,38 +714,37 @@ void init_listener() {
     parser_needs_reset = true;
 }
 
-void request_file_list(const char* dirname) {
-    send_linef("$Files/ListGCode=%s", dirname);
+void request_file_list(const char* dirname, const command_done_t& done) {
+    std::string cmd("$Files/ListGCode=");
+    cmd += dirname;
+    send_line(cmd.c_str(), CMD_FILE_TIMEOUT_MS, done);
     // parser.reset();
     parser_needs_reset = true;
 }
 
-void init_file_list() {
+void init_file_list(const command_done_t& done) {
     init_listener();
-    request_file_list("/sd");
+    fileIndex.anchorFirst();
+    request_file_list("/sd", done);
     parser.reset();
 }
 
 void request_file_preview(const char* name, int firstline, int nlines) {
     reading_macros = false;
-    send_linef("$File/ShowSome=%d:%d,%s", firstline, firstline + nlines, name);
+    send_linef_timeout(CMD_FILE_TIMEOUT_MS, "$File/ShowSome=%d:%d,%s", firstline, firstline + nlines, name);
     // parser.reset();
 }
 
-void parser_parse_line(const char* line) {
-    char c;
-    while ((c = *line++) != '\0') {
-        parser.parse(c);
-    }
-}
-
-extern "C" void handle_json(const char* line) {
+// line is the payload of a [JSON:...] message.  It is scanned in place
+// and does not survive the call.
+void handle_json(char* line) {
+    PROFILE_SCOPE(PROF_JSON);
     if (parser_needs_reset) {
         parser_needs_reset = false;
         parser.setListener(pInitialListener);
         parser.reset();
     }
-    parser_parse_line(line);
+    parser.parse(line);
 
 #define Ack 0xB2
     fnc_realtime((realtime_cmd_t)Ack);
@@ -625,33 +783,48 @@ void handle_radio_mode(char* command, char* arguments) {
     wifi_mode = value;
     if (strcmp(value, "No Wifi") != 0) {
         parse_wifi(arguments);
-        current_scene->reDisplay();
+        request_redraw();
     }
 }
 
-extern "C" void handle_msg(char* command, char* arguments) {
-    if (strcmp(command, "Homed") == 0) {
-        char c;
-        while ((c = *arguments++) != '\0') {
-            const char* letters = "XYZABCUVW";
-            char*       pos     = strchr(letters, c);
-            if (pos) {
-                set_axis_homed(pos - letters);
-            }
-        }
-    }
-    if (strcmp(command, "RST") == 0) {
-        dbg_println("FluidNC Reset");
-        state = Disconnected;
-        act_on_state_change();
-    }
-    if (strcmp(command, "Files changed") == 0) {
-        init_file_list();
-    }
-    if (strcmp(command, "JSON") == 0) {
-        handle_json(arguments);
-    }
+static void ui_handle_msg(char* command, char* arguments) {
     if (strncmp(command, "Mode=", strlen("Mode=")) == 0) {
         handle_radio_mode(command, arguments);
+        return;
+    }
+    switch (str_hash(command)) {
+        case str_hash("Homed"):
+            if (str_is(command, "Homed")) {
+                char c;
+                while ((c = *arguments++) != '\0') {
+                    const char* letters = "XYZABCUVW";
+                    char*       pos     = strchr(letters, c);
+                    if (pos) {
+                        set_axis_homed(pos - letters);
+                    }
+                }
+            }
+            break;
+        case str_hash("RST"):
+            if (str_is(command, "RST")) {
+                dbg_println("FluidNC Reset");
+                set_disconnected_state();  // Unanswered commands were dropped
+                act_on_state_change();
+            }
+            break;
+        case str_hash("Files changed"):
+            if (str_is(command, "Files changed")) {
+                init_file_list();
+            }
+            break;
+        case str_hash("JSON"):
+            if (str_is(command, "JSON")) {
+                handle_json(arguments);
+            }
+            break;
     }
 }
+
+extern "C" void handle_msg(char* command, char* arguments) {
+    run_on_ui_copy(command, arguments, [](char* c, char* a) { ui_handle_msg(c, a); });
+}
@@ -6,16 +6,96 @@
 
 typedef void (*callback_t)(void*);
 
-struct fileinfo {
-    std::string fileName;
-    int         fileSize;
-    bool        isDir() const { return fileSize < 0; }
+#include <stdint.h>
+#include <stddef.h>
+
+#include "CommandQueue.h"  // command_done_t
+
+// Directory listing storage.  Names are packed into a fixed-size arena
+// instead of one heap string per entry, and entries are inserted in
+// display order as they arrive (files first, then folders, each by
+// name), so there is no sort pass when the list ends.
+//
+// A directory can hold more entries than the index, so the index keeps a
+// window of the sorted listing.  By default that is the first entries.
+// After setAnchor() it is the entries centered on a given one, and after
+// anchorLast() it is the last entries.  FluidNC always sends the whole
+// directory, so the window is chosen as the entries stream in.  first()
+// is the position of the window in the full listing, and total() counts
+// every entry received.
+#ifndef FILE_INDEX_BYTES
+#    define FILE_INDEX_BYTES 12288
+#endif
+#ifndef FILE_INDEX_ENTRIES
+#    define FILE_INDEX_ENTRIES 512
+#endif
+
+class FileIndex {
+private:
+    struct entry_t {
+        uint16_t offset;  // of the NUL-terminated name in _arena
+        int32_t  size;    // negative for a folder
+    };
+
+    char    _arena[FILE_INDEX_BYTES];
+    size_t  _used = 0;
+    size_t  _dead = 0;  // Bytes of dropped names in the arena, reclaimed by compact()
+    entry_t _entries[FILE_INDEX_ENTRIES];
+    size_t  _count     = 0;
+    bool    _truncated = false;
+
+    typedef enum {
+        FIRST,
+        AROUND,
+        LAST,
+    } anchor_t;
+    anchor_t    _anchor = FIRST;
+    std::string _anchor_name;
+    int         _anchor_size = 0;
+
+    // Once entries have been trimmed from either end of the window, anything
+    // that sorts beyond the trimmed ones must be kept out too
+    std::string _floor_name;
+    int         _floor_size  = 0;
+    bool        _have_floor  = false;
+    std::string _ceiling_name;
+    int         _ceiling_size = 0;
+    bool        _have_ceiling = false;
+
+    size_t _below       = 0;  // Resident entries that sort before the anchor
+    size_t _total_below = 0;  // All entries that sort before the anchor
+    size_t _total       = 0;
+
+    bool less(const char* name1, int size1, const char* name2, int size2) const;
+    void compact();
+    void drop_first();
+    void drop_last();
+
+public:
+    void clear();
+    void add(const char* name, int size);
+
+    void anchorFirst() { _anchor = FIRST; }
+    void anchorLast() { _anchor = LAST; }
+    void setAnchor(const char* name, int size);
+
+    // Index of the anchor entry, or where it would be
+    size_t anchorIndex() const;
+
+    size_t      size() const { return _count; }
+    size_t      first() const { return _total_below - _below; }
+    size_t      total() const { return _total; }
+    bool        truncated() const { return _truncated; }
+    const char* name(size_t i) const { return &_arena[_entries[i].offset]; }
+    int         fileSize(size_t i) const { return _entries[i].size; }
+    bool        isDir(size_t i) const { return _entries[i].size < 0; }
 };
 
-extern fileinfo              fileInfo;
-extern std::vector<fileinfo> fileVector;
+extern FileIndex fileIndex;
 
-extern void request_file_list(const char* dirname);
+// done, if given, is called when FluidNC answers the request; a nonzero
+// status means that no listing is coming
+extern void request_file_list(const char* dirname, const command_done_t& done = nullptr);
 
 struct Macro {
     std::string name;
@@ -33,4 +113,4 @@ extern std::string current_filename;
 extern std::string wifi_mode, wifi_ip, wifi_connected, wifi_ssid;
 
 void init_listener();
-void init_file_list();
+void init_file_list(const command_done_t& done = nullptr);
@@ -4,64 +4,298 @@
 #include <string>
 #include "Scene.h"
 #include "FileParser.h"
-#include <map>
+#include "GCodePreview.h"
+#include <algorithm>
+#include <cstring>
 
 extern Scene menuScene;
 extern Scene statusScene;
 
+// Lines of the previewed file are kept in a ring around the displayed
+// ones, and more are read ahead in the direction of scrolling, so small
+// scroll steps are served without a round trip to FluidNC.
+#ifndef PREVIEW_CACHE_LINES
+#    define PREVIEW_CACHE_LINES 35
+#endif
+
 class FilePreviewScene : public Scene {
     std::string _error_string;
     std::string _filename;
-    bool        _needlines;
     int         _firstline = 0;
-
-    std::map<int, std::string> _lines;
+    int         _direction = 1;
 
     static const int _nlines = 7;
+    static const int _chunk  = 2 * _nlines;  // Lines per request
 
-public:
-    FilePreviewScene() : Scene("Preview", 4) {}
-    void get_lines() {
-        _needlines = true;
-        request_file_preview(_filename.c_str(), _firstline, _nlines);
+    static_assert(PREVIEW_CACHE_LINES >= _chunk + 2 * _nlines, "PREVIEW_CACHE_LINES is too small");
+
+    // Lines [_cache_first, _cache_end) of the file, indexed by line number modulo the ring size
+    std::string _cache[PREVIEW_CACHE_LINES];
+    int         _cache_first = 0;
+    int         _cache_end   = 0;
+    int         _eof         = -1;  // The number of lines in the file, once known
+
+    // Only one $File/ShowSome is outstanding at a time
+    bool _pending       = false;
+    bool _pending_path  = false;  // The request is for the toolpath
+    int  _pending_first = 0;
+    int  _pending_count = 0;
+
+    // Touching the screen switches between the text and the toolpath.
+    // The toolpath is built by streaming the whole file through the preview.
+    static const int _path_chunk   = 40;  // Lines per request
+    static const int _path_area    = 160;
+    bool             _show_path    = false;
+    bool             _path_done    = false;
+    int              _path_next    = 0;
+    int              _path_chunks  = 0;
+    GCodePreview     _path;
+
+    // The toolpath is painted into a 1-bit sprite as it is read, and only
+    // the cells set since the last redraw are added.  Rescaling the grid or
+    // growing the occupied range moves every cell, so that repaints it all.
+    LGFX_Sprite* _path_sprite = nullptr;
+    uint32_t     _drawn[GCodePreview::WORDS];
+    int          _drawn_generation = -1;
+    int          _drawn_bounds[4]  = {};
+
+    int window_end() {
+        int end = _firstline + _nlines;
+        return (_eof >= 0 && end > _eof) ? _eof : end;
+    }
+    bool window_cached() {
+        int end = window_end();
+        return end <= _firstline || (_firstline >= _cache_first && end <= _cache_end);
+    }
+
+    void request(int first, int count, bool path = false) {
+        if (first < 0) {
+            count += first;
+            first = 0;
+        }
+        if (count <= 0) {
+            return;
+        }
+        _pending       = true;
+        _pending_path  = path;
+        _pending_first = first;
+        _pending_count = count;
+        request_file_preview(_filename.c_str(), first, count);
+    }
+
+    void fetch() {
+        if (_pending) {
+            return;
+        }
+        if (_show_path) {
+            if (!_path_done) {
+                request(_path_next, _path_chunk, true);
+            }
+            return;
+        }
+        if (!window_cached()) {
+            if (_direction > 0) {
+                request(_firstline, _chunk);
+            } else {
+                request(_firstline + _nlines - _chunk, _chunk);
+            }
+            return;
+        }
+        // Read ahead in the direction of scrolling
+        if (_direction > 0) {
+            if ((_eof < 0 || _cache_end < _eof) && _cache_end - window_end() < _nlines) {
+                request(_cache_end, _chunk);
+            }
+        } else {
+            if (_cache_first > 0 && _firstline - _cache_first < _nlines) {
+                request(_cache_first - _chunk, _chunk);
+            }
+        }
     }
 
+public:
+    FilePreviewScene() : Scene("Preview", 4) { setEncoderAcceleration(6, 10); }
+
     void onEntry(void* arg) {
         if (arg) {
             char* fname = (char*)arg;
             _filename   = fname;
-            get_lines();
-        } else {
-            _needlines = false;
+            _error_string.clear();
+            _firstline   = 0;
+            _direction   = 1;
+            _cache_first = 0;
+            _cache_end   = 0;
+            _eof         = -1;
+            _pending     = false;
+            _show_path   = false;
+            _path_done   = false;
+            _path_next   = 0;
+            _path_chunks = 0;
+            _path.reset();
+            _drawn_generation = -1;
+            fetch();
         }
     }
+    void onPathLines(const std::vector<std::string>& lines) {
+        for (auto const& line : lines) {
+            _path.parseLine(line.c_str());
+        }
+        _path_next += lines.size();
+        _path_done = (int)lines.size() < _pending_count;
+        // Redrawing is slow compared to parsing, so show progress only now and then
+        if (_path_done || (++_path_chunks % 8) == 0) {
+            request_redraw();
+        }
+        fetch();
+    }
     void onFileLines(int firstline, const std::vector<std::string>& lines) {
         _error_string.clear();
-        _needlines = false;
-        _lines.clear();
-        for (auto const& line : lines) {
-            _lines[firstline++] = line;
+        _pending = false;
+        if (_pending_path) {
+            if (_show_path) {
+                onPathLines(lines);
+            } else {
+                fetch();
+            }
+            return;
+        }
+        if (_show_path) {
+            fetch();
+            return;
+        }
+
+        int n = lines.size();
+        if (firstline == _pending_first && n < _pending_count) {
+            _eof = firstline + n;
+        }
+        if (n > PREVIEW_CACHE_LINES) {
+            n = PREVIEW_CACHE_LINES;
+        }
+        int end = firstline + n;
+        if (end < _cache_first || firstline > _cache_end) {
+            // Not contiguous with what we have, so start over
+            _cache_first = _cache_end = firstline;
         }
-        reDisplay();
+        for (int i = 0; i < n; i++) {
+            _cache[(firstline + i) % PREVIEW_CACHE_LINES] = lines[i];
+        }
+        // Keep the new lines, dropping old ones from the far end
+        bool at_end  = firstline >= _cache_first;
+        _cache_first = std::min(_cache_first, firstline);
+        _cache_end   = std::max(_cache_end, end);
+        if (_cache_end - _cache_first > PREVIEW_CACHE_LINES) {
+            if (at_end) {
+                _cache_first = _cache_end - PREVIEW_CACHE_LINES;
+            } else {
+                _cache_end = _cache_first + PREVIEW_CACHE_LINES;
+            }
+        }
+        request_redraw();
+        fetch();
     }
     void onError(const char* errstr) {
         _error_string = errstr;
-        reDisplay();
+        _pending      = false;
+        request_redraw();
     }
     void scroll(int updown) {
-        if (updown == 0) {
+        if (updown == 0 || _show_path) {
             return;
         }
-        int fl = _firstline;
-        fl += updown;
-        if (fl >= 0) {
+        int fl = _firstline + updown;
+        if (_eof >= 0 && fl >= _eof) {
+            fl = _eof - 1;
+        }
+        if (fl < 0) {
+            fl = 0;  // Also keeps an empty file at line 0
+        }
+        if (fl != _firstline) {
             _firstline = fl;
-            get_lines();
+            _direction = updown > 0 ? 1 : -1;
+            fetch();
+            if (window_cached()) {
+                request_redraw();
+            }
         }
     }
 
     void onDialButtonPress() { pop_scene(); }
 
+    void onTouchClick() override {
+        _show_path = !_show_path;
+        fetch();
+        request_redraw();
+    }
+
+    void drawPath() {
+        int min_x, min_y, max_x, max_y;
+        if (!_path.bounds(min_x, min_y, max_x, max_y)) {
+            text(_path_done ? "No Toolpath" : "Reading File", 120, 120, WHITE, TINY, middle_center);
+            return;
+        }
+        if (!_path_sprite) {
+            _path_sprite = new LGFX_Sprite(&canvas);
+            _path_sprite->setColorDepth(1);
+            if (_path_sprite->createSprite(_path_area, _path_area)) {
+                _path_sprite->createPalette();
+                _path_sprite->setPaletteColor(1, (uint16_t)GREEN);
+            } else {
+                delete _path_sprite;
+                _path_sprite = nullptr;
+            }
+        }
+
+        // Scale the occupied cells up to fill the area
+        int span   = std::max(max_x - min_x, max_y - min_y) + 1;
+        int scale  = std::max(_path_area / span, 1);
+        int left   = (_path_area - (max_x - min_x + 1) * scale) / 2;
+        int bottom = (_path_area + (max_y - min_y + 1) * scale) / 2;
+        int corner = 120 - _path_area / 2;
+
+        // Without the sprite, every redraw paints every cell on the canvas
+        LGFX_Sprite* dst    = _path_sprite ? _path_sprite : &canvas;
+        int          origin = _path_sprite ? 0 : corner;
+        int          color  = _path_sprite ? 1 : GREEN;
+
+        int bounds[4] = { min_x, min_y, max_x, max_y };
+        if (!_path_sprite || _drawn_generation != _path.generation() || memcmp(bounds, _drawn_bounds, sizeof(bounds))) {
+            if (_path_sprite) {
+                _path_sprite->fillSprite(0);
+            }
+            memset(_drawn, 0, sizeof(_drawn));
+            memcpy(_drawn_bounds, bounds, sizeof(bounds));
+            _drawn_generation = _path.generation();
+        }
+        const int words_per_row = GCodePreview::GRID / 32;
+        for (int n = 0; n < GCodePreview::WORDS; n++) {
+            uint32_t fresh = _path.word(n) & ~_drawn[n];
+            _drawn[n] |= fresh;
+            while (fresh) {
+                int cx = n % words_per_row * 32 + __builtin_ctz(fresh);
+                int cy = n / words_per_row;
+                fresh &= fresh - 1;
+                dst->fillRect(origin + left + (cx - min_x) * scale, origin + bottom - (cy - min_y + 1) * scale, scale, scale, color);
+            }
+        }
+        if (_path_sprite) {
+            _path_sprite->pushSprite(&canvas, corner, corner, 0);
+        }
+        markDirty(corner, corner, _path_area, _path_area);
+        if (!_path_done) {
+            std::string progress = std::to_string(_path.lines()) + " lines";
+            centered_text(progress.c_str(), 205, LIGHTGREY, TINY);
+        }
+    }
+
+    void onExit() override {
+        if (_path_sprite) {
+            _path_sprite->deleteSprite();
+            delete _path_sprite;
+            _path_sprite = nullptr;
+        }
+        _drawn_generation = -1;
+    }
+
     void onEncoder(int delta) override { scroll(delta); }
 
     void onRedButtonPress() {
@@ -71,7 +305,7 @@ public:
         }
     }
 
-    void onDROChange() { reDisplay(); }
+    void onDROChange() { request_redraw(); }
 
     void onGreenButtonPress() {
         if (state == Idle) {
@@ -94,19 +328,21 @@ public:
         const char* redLabel = "";
 
         if (state == Idle) {
-            if (_needlines == false) {
+            if (_error_string.length()) {
+                text(_error_string, 120, 120, WHITE, SMALL, middle_center);
+            } else if (_show_path) {
+                drawPath();
+            } else if (window_cached()) {
                 int y  = 48;
                 int tl = 0;
-                if (_lines.size()) {
-                    for (auto const& entry : _lines) {
-                        text(entry.second.c_str(), 25, y + tl * 22, WHITE, TINY, top_left);
+                if (_eof != 0) {
+                    for (int line = _firstline; line < window_end(); line++) {
+                        text(_cache[line % PREVIEW_CACHE_LINES].c_str(), 25, y + tl * 22, WHITE, TINY, top_left);
                         ++tl;
                     }
                 } else {
                     text("Empty File", 120, 120, WHITE, SMALL, middle_center);
                 }
-            } else if (_error_string.length()) {
-                text(_error_string, 120, 120, WHITE, SMALL, middle_center);
             } else {
                 text("Reading File", 120, 120, WHITE, TINY, middle_center);
             }
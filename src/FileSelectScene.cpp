@@ -19,11 +19,221 @@ extern Scene& mfScene;
 
 class FileSelectScene : public Scene {
 private:
-    int              _selected_file = 0;
-    std::vector<int> prevSelect;
-    std::string      dirName         = "/sd";
-    int              dirLevel        = 0;
-    bool             _selecting_file = false;
+    // _selected_file is a position in the whole directory listing, of
+    // which fileIndex holds a window.  The window is refetched around the
+    // selection when it gets close to an edge.
+    int         _selected_file  = 0;
+    std::string dirName         = "/sd";
+    int         dirLevel        = 0;
+    bool        _selecting_file = false;
+    bool        _fetching       = false;
+    int         _fetch_serial   = 0;  // Identifies the latest listing request
+
+    // How close the selection can get to the edge of the window
+    static const int WINDOW_MARGIN = 3;
+
+#ifdef SMOOTH_SCROLL
+    // Animated scrolling.  While the selection is moving, the filenames
+    // are drawn from a strip sprite holding STRIP_ROWS rows around the
+    // scroll position, and _scroll_pos (in 1/256ths of a row) eases toward
+    // _selected_file at one frame per SCROLL_FRAME_MS.  Moving the strip
+    // by whole rows scrolls the sprite and draws only the exposed rows,
+    // so a fast spin does not redraw every filename it passes.  The title,
+    // legends and status are painted once when scrolling starts; each frame
+    // repaints and pushes only the band that holds the list.  The full
+    // display with file info is drawn when the animation settles.
+    static const int STRIP_ROWS      = 9;
+    static const int STRIP_WIDTH     = 200;
+    static const int ROW_HEIGHT      = 22;
+    static const int LIST_HALF       = 66;  // Visible half height of the list
+    static const int SCROLL_FRAME_MS = 20;
+
+    LGFX_Sprite* _strip        = nullptr;
+    bool         _strip_valid  = false;
+    int          _strip_first  = 0;  // File number in the top row of the strip
+    int          _scroll_pos   = 0;
+    bool         _scrolling    = false;
+    bool         _backdrop     = false;  // The parts outside the list band are drawn
+    uint32_t     _next_frame   = 0;
+
+    // File number n with wrapping applied, or -1 if there is no such row
+    int wrapped(int n) {
+#    ifdef WRAP_FILE_LIST
+        if (num_files() > 2) {
+            n %= num_files();
+            if (n < 0) {
+                n += num_files();
+            }
+        }
+#    endif
+        return (n >= 0 && n < num_files()) ? n : -1;
+    }
+
+    void draw_strip_row(int row) {
+        int y = row * ROW_HEIGHT;
+        _strip->fillRect(0, y, STRIP_WIDTH, ROW_HEIGHT, BLACK);
+        int n = wrapped(_strip_first + row);
+        if (n >= 0 && resident(n)) {
+            auto_text(_strip, fileIndex.name(slot(n)), STRIP_WIDTH / 2, y + ROW_HEIGHT / 2, STRIP_WIDTH, WHITE, TINY, middle_center, false);
+        }
+    }
+
+    // Moves the strip so that it covers the rows visible at _scroll_pos
+    bool update_strip() {
+        if (!_strip) {
+            _strip = new LGFX_Sprite(&canvas);
+            _strip->setColorDepth(canvas.getColorDepth());
+            if (!_strip->createSprite(STRIP_WIDTH, STRIP_ROWS * ROW_HEIGHT)) {
+                delete _strip;
+                _strip = nullptr;
+                return false;
+            }
+        }
+        int center    = _scroll_pos >> 8;
+        int new_first = center - STRIP_ROWS / 2;
+        int shift     = new_first - _strip_first;
+        if (_strip_valid && center - _strip_first >= STRIP_ROWS / 2 - 1 && center - _strip_first <= STRIP_ROWS / 2) {
+            return true;
+        }
+        _strip_first = new_first;
+        if (_strip_valid && shift > -STRIP_ROWS && shift < STRIP_ROWS) {
+            _strip->scroll(0, -shift * ROW_HEIGHT);
+            if (shift > 0) {
+                for (int row = STRIP_ROWS - shift; row < STRIP_ROWS; row++) {
+                    draw_strip_row(row);
+                }
+            } else {
+                for (int row = 0; row < -shift; row++) {
+                    draw_strip_row(row);
+                }
+            }
+        } else {
+            for (int row = 0; row < STRIP_ROWS; row++) {
+                draw_strip_row(row);
+            }
+        }
+        _strip_valid = true;
+        return true;
+    }
+
+    void drawScrollFrame() {
+        if (!update_strip()) {
+            _scrolling = false;
+            showFiles();
+            return;
+        }
+        Point center = Point(x_offset, 0).to_display();
+        int   top    = center.y - LIST_HALF;
+
+        if (!_backdrop) {
+            background();
+            drawMenuTitle(current_scene->name());
+            buttonLegends();
+            drawStatus();
+            _backdrop = true;
+        } else {
+            // Restore just the band from the background
+            canvas.setClipRect(0, top, canvas.width(), LIST_HALF * 2);
+            system_background();
+            canvas.clearClipRect();
+            markDirty(0, top, canvas.width(), LIST_HALF * 2);
+        }
+        drawRect(Point(x_offset, 0), big_width, ROW_HEIGHT + 6, (ROW_HEIGHT + 6) / 2, DARKGREY);
+
+        int y = center.y - ROW_HEIGHT / 2 - (((_scroll_pos - (_strip_first << 8)) * ROW_HEIGHT) >> 8);
+        canvas.setClipRect(0, top, canvas.width(), LIST_HALF * 2);
+        _strip->pushSprite(&canvas, center.x - STRIP_WIDTH / 2, y, BLACK);
+        canvas.clearClipRect();
+
+        refreshDisplay();
+    }
+
+    void start_scroll(int from) {
+        if (!_scrolling) {
+            _scrolling  = true;
+            _backdrop   = false;
+            _scroll_pos = from << 8;
+            _next_frame = milliseconds();
+        }
+    }
+
+    void onPoll() override {
+        if (!_scrolling || (int32_t)(milliseconds() - _next_frame) < 0) {
+            return;
+        }
+        _next_frame = milliseconds() + SCROLL_FRAME_MS;
+
+        int target = _selected_file << 8;
+        int diff   = target - _scroll_pos;
+        // Jumps, such as wrapping from one end of the list to the other, are not animated
+        if (diff > (STRIP_ROWS << 8) || diff < -(STRIP_ROWS << 8) || (diff >= -32 && diff <= 32)) {
+            _scrolling  = false;
+            _scroll_pos = target;
+            showFiles();
+            return;
+        }
+        int step = diff / 4;  // Ease out
+        if (step > -32 && step < 32) {
+            step = diff > 0 ? 32 : -32;
+        }
+        _scroll_pos += step;
+        drawScrollFrame();
+    }
+
+    void onExit() override {
+        _scrolling   = false;
+        _strip_valid = false;
+        if (_strip) {
+            _strip->deleteSprite();
+            delete _strip;
+            _strip = nullptr;
+        }
+    }
+#endif
+
+    int  num_files() { return fileIndex.total(); }
+    bool resident(int n) { return n >= (int)fileIndex.first() && n < (int)(fileIndex.first() + fileIndex.size()); }
+    int  slot(int n) { return n - fileIndex.first(); }
+
+    // Marks a listing as in progress and returns the callback for its
+    // request.  The ok that ends a listing arrives after onFilesList(), so
+    // only a failed or unanswered request needs to clear _fetching here.
+    command_done_t start_fetch() {
+        _fetching  = true;
+        int serial = ++_fetch_serial;
+        return [this, serial](int status, int) {
+            if (status && serial == _fetch_serial) {
+                _fetching = false;
+            }
+        };
+    }
+
+    void fetch_window() {
+        if (resident(_selected_file)) {
+            int i = slot(_selected_file);
+            fileIndex.setAnchor(fileIndex.name(i), fileIndex.fileSize(i));
+        } else if (_selected_file == 0) {
+            fileIndex.anchorFirst();
+        } else if (_selected_file == num_files() - 1) {
+            fileIndex.anchorLast();  // Wrapped around to the end
+        } else {
+            // scroll() keeps the selection in the window, but if it gets
+            // out, stay with the nearest entry that is loaded
+            int i = _selected_file < (int)fileIndex.first() ? 0 : fileIndex.size() - 1;
+            fileIndex.setAnchor(fileIndex.name(i), fileIndex.fileSize(i));
+        }
+        request_file_list(dirName.c_str(), start_fetch());
+    }
+
+    void check_window() {
+        int  first       = fileIndex.first();
+        int  last        = first + fileIndex.size();
+        bool more_before = first > 0;
+        bool more_after  = last < num_files();
+        if ((more_before && _selected_file - first < WINDOW_MARGIN) || (more_after && last - _selected_file <= WINDOW_MARGIN)) {
+            fetch_window();
+        }
+    }
 
     const char* format_size(size_t size) {
         const int   buflen = 30;
@@ -43,14 +253,7 @@ private:
     }
 
 public:
-    FileSelectScene() : Scene("Files", 4) {}
-
-    void onEntry(void* arg) {
-        // a first time only thing, because files are already loaded
-        if (prevSelect.size() == 0) {
-            prevSelect.push_back(0);
-        }
-    }
+    FileSelectScene() : Scene("Files", 4) { setEncoderAcceleration(6, 10); }
 
     void onDialButtonPress() { pop_scene(); }
 
@@ -58,19 +261,18 @@ public:
         if (state != Idle) {
             return;
         }
-        if (fileVector.size()) {
-            fileInfo                                 = fileVector[_selected_file];
-            prevSelect[(int)(prevSelect.size() - 1)] = _selected_file;
-            if (fileInfo.isDir()) {
-                prevSelect.push_back(0);
+        if (!_fetching && resident(_selected_file)) {
+            int i = slot(_selected_file);
+            if (fileIndex.isDir(i)) {
                 dirName += "/";
-                dirName += fileInfo.fileName;
+                dirName += fileIndex.name(i);
                 ++dirLevel;
-                request_file_list(dirName.c_str());
+                fileIndex.anchorFirst();
+                request_file_list(dirName.c_str(), start_fetch());
             } else {
                 std::string path(dirName);
                 path += "/";
-                path += fileInfo.fileName;
+                path += fileIndex.name(i);
                 push_scene(&filePreviewScene, (void*)path.c_str());
             }
         }
@@ -82,15 +284,14 @@ public:
             return;
         }
         if (dirLevel) {
-            prevSelect.pop_back();
+            // Come back to the folder we are leaving
             auto pos = dirName.rfind('/');
-            dirName  = dirName.substr(0, pos);
+            fileIndex.setAnchor(dirName.substr(pos + 1).c_str(), -1);
+            dirName = dirName.substr(0, pos);
             --dirLevel;
-            request_file_list(dirName.c_str());
+            request_file_list(dirName.c_str(), start_fetch());
         } else {
-            prevSelect.clear();
-            prevSelect.push_back(0);
-            init_file_list();
+            init_file_list(start_fetch());
         }
         ackBeep();
     }
@@ -103,12 +304,18 @@ public:
         }
     }
     void onFilesList() override {
-        _selected_file = prevSelect.back();
-        reDisplay();
+        _fetching      = false;
+        _selected_file = fileIndex.first() + fileIndex.anchorIndex();
+#ifdef SMOOTH_SCROLL
+        _strip_valid = false;
+#endif
+        request_redraw();
     }
 
     void onEncoder(int delta) override { scroll(delta); }
 
+    void onError(const char*) override { _fetching = false; }
+
     void onMessage(char* command, char* arguments) override {
         dbg_printf("FileSelectScene::onMessage(\"%s\", \"%s\")\r\n", command, arguments);
         // now just need to know what to do with messages
@@ -120,8 +327,8 @@ public:
 
         if (state == Idle) {
             redLabel = dirLevel ? "Up.." : "Refresh";
-            if (fileVector.size()) {
-                grnLabel = fileVector[_selected_file].isDir() ? "Down.." : "Load";
+            if (resident(_selected_file)) {
+                grnLabel = fileIndex.isDir(slot(_selected_file)) ? "Down.." : "Load";
             }
         }
 
@@ -190,11 +397,11 @@ public:
             auto fnlayout = fnlayouts[display_slot];
 
 #ifdef WRAP_FILE_LIST
-            if (fileVector.size() > 2) {
+            if (num_files() > 2) {
                 if (fdIter < 0) {
                     // last file first in list
-                    fdIter = fileVector.size() - 1;
-                } else if (fdIter > fileVector.size() - 1) {
+                    fdIter = num_files() - 1;
+                } else if (fdIter > num_files() - 1) {
                     // first file last in list
                     fdIter = 0;
                 }
@@ -205,8 +412,9 @@ public:
             }
 
             fName = "< no files >";
-            if (fileVector.size()) {
-                fName = fileVector[fdIter].fileName;
+            if (num_files()) {
+                // Entries outside the window are blank until it is refetched
+                fName = resident(fdIter) ? fileIndex.name(slot(fdIter)) : "";
             }
             int middle_slot = (N_DISPLAYED_FILENAMES - 1) / 2;
             int offset      = middle_slot - display_slot;
@@ -217,8 +425,8 @@ public:
                 std::string fInfoT = "";  // file info top line
                 std::string fInfoB = "";  // File info bottom line
                 int         ext    = fName.rfind('.');
-                if (fileVector.size()) {
-                    if (fileVector[_selected_file].isDir()) {
+                if (resident(_selected_file)) {
+                    if (fileIndex.isDir(slot(_selected_file))) {
                         fInfoB = "Folder";
                         tcolor = BLUE;
                     } else {
@@ -227,7 +435,7 @@ public:
                             fInfoT += " file";
                             fName.erase(ext);
                         }
-                        fInfoB = format_size(fileVector[_selected_file].fileSize);
+                        fInfoB = format_size(fileIndex.fileSize(slot(_selected_file)));
                     }
                 }
 
@@ -235,7 +443,7 @@ public:
                 // in the larger list of files.
                 // If there are at most three files, all are displayed, without
                 // a scroll indicator.
-                if (fileVector.size() > 3) {
+                if (num_files() > 3) {
                     int width  = 8;
                     int radius = width / 2;
                     if (round_display) {
@@ -245,7 +453,7 @@ public:
 
                         int x, y;
                         int arc_degrees = 100;
-                        int divisor     = fileVector.size() - 1;
+                        int divisor     = num_files() - 1;
                         int increment   = arc_degrees / divisor;
                         int start_angle = (arc_degrees / 2);
                         int angle       = start_angle - (_selected_file * arc_degrees) / divisor;
@@ -256,7 +464,7 @@ public:
                         int height       = display_short_side() - 30;
                         int inner_height = height - width;
                         int middle       = inner_height / 2;
-                        int divisor      = fileVector.size() - 1;
+                        int divisor      = num_files() - 1;
                         int y            = width + inner_height * _selected_file / divisor;
                         drawRect(x - radius, radius, width + 2, height, radius, DARKGREY);
                         drawFilledCircle(x, y, radius + 1, LIGHTGREY);
@@ -269,11 +477,11 @@ public:
                 auto_text(fName, Point(x_offset, 0), fnlayout._w, tcolor, MEDIUM, middle_center);
 
 #ifdef WRAP_FILE_LIST
-                if (fileVector.size() >= N_DISPLAYED_FILENAMES) {
+                if (num_files() >= N_DISPLAYED_FILENAMES) {
                     continue;
                 }
 #endif
-                if (fdIter >= (int)(fileVector.size() - 1)) {
+                if (fdIter >= (int)(num_files() - 1)) {
                     break;
                 }
             } else {
@@ -304,30 +512,61 @@ public:
     }
 
     void scroll(int updown) {
+        if (_fetching) {
+            return;
+        }
         int nextSelect = _selected_file + updown;
 #ifdef WRAP_FILE_LIST
-        if (fileVector.size() < 3) {
-            if (nextSelect < 0 || nextSelect > (int)(fileVector.size() - 1)) {
+        if (num_files() < 3) {
+            if (nextSelect < 0 || nextSelect > (int)(num_files() - 1)) {
                 return;
             }
-        } else {
-            if (nextSelect < 0) {
-                nextSelect = fileVector.size() - 1;
-            } else if (nextSelect > (int)(fileVector.size() - 1)) {
-                nextSelect = 0;
+        } else if (nextSelect < 0 || nextSelect > (int)(num_files() - 1)) {
+            // An accelerated step carries on around the end of the list
+            int total   = num_files();
+            int wrapped = ((nextSelect % total) + total) % total;
+            // Unless the listing is only partly loaded, where fetch_window()
+            // can only anchor on the far end itself
+            if (!resident(wrapped)) {
+                wrapped = nextSelect < 0 ? total - 1 : 0;
             }
+            nextSelect = wrapped;
         }
 #else
-        if (nextSelect < 0 || nextSelect > (int)(fileVector.size() - 1)) {
+        // An accelerated spin stops at the ends of the list
+        if (nextSelect < 0) {
+            nextSelect = 0;
+        } else if (nextSelect > (int)(num_files() - 1)) {
+            nextSelect = num_files() - 1;
+        }
+        if (nextSelect == _selected_file) {
             return;
         }
 #endif
+        // A long listing is only partly loaded.  An accelerated step stops
+        // at the edge of what is loaded, and check_window() fetches more.
+        if (!resident(nextSelect) && fileIndex.size() && nextSelect != 0 && nextSelect != num_files() - 1) {
+            nextSelect = nextSelect < (int)fileIndex.first() ? fileIndex.first() : fileIndex.first() + fileIndex.size() - 1;
+        }
 
+#ifdef SMOOTH_SCROLL
+        start_scroll(_selected_file);
         _selected_file = nextSelect;
-        showFiles();
+        check_window();
+#else
+        _selected_file = nextSelect;
+        check_window();
+        request_redraw();
+#endif
     }
 
     void reDisplay() {
+#ifdef SMOOTH_SCROLL
+        if (_scrolling) {
+            _backdrop = false;  // The next frame repaints everything
+            return;
+        }
+#endif
         showFiles();
     }
 };
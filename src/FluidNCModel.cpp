@@ -4,29 +4,21 @@
 #include "FluidNCModel.h"
 #include "ConfigItem.h"
 #include "FileParser.h"  // init_file_list()
-#include <map>
 #include "System.h"
 #include "Scene.h"
 #include "e4math.h"
 #include "HomingScene.h"
+#include "JogStreamer.h"  // detect_jog_limits()
+#include "InputQueue.h"
+#include "ProtocolTask.h"
+#include "StrHash.h"
 
 extern Scene statusScene;
 
 // local copies of status items
-const char*        my_state_string    = "N/C";
-state_t            state              = Idle;
-int                n_axes             = 3;
-pos_t              myAxes[6]          = { 0 };
-bool               myLimitSwitches[6] = { false };
-bool               myProbeSwitch      = false;
-const char*        myFile             = "";  // running SD filename
-const char*        myCtrlPins         = "";
-file_percent_t     myPercent          = 0.0;  // percent conplete of SD file
-override_percent_t myFro              = 100;  // Feed rate override
-override_percent_t mySro              = 100;  // Spindle Override
-uint32_t           myFeed             = 0;
-uint32_t           mySpeed            = 0;
-uint32_t           mySelectedTool     = 0;
+const char* my_state_string = "N/C";
+state_t     state           = Idle;
+uint32_t    mySelectedTool  = 0;
 
 std::string myModes = "no data";
 
@@ -39,111 +31,181 @@ int num_digits() {
     return inInches ? 3 : 2;
 }
 
-// clang-format off
-// Maps the state strings in status reports to internal state enum values
-struct cmp_str {
-   bool operator()(char const *a, char const *b) const    {
-      return strcmp(a, b) < 0;
-   }
-};
-
-std::map<const char *, state_t, cmp_str>  state_map = {
-    { "Idle", Idle },
-    { "Alarm", Alarm },
-    { "Hold:0", Hold },
-    { "Hold:1", Hold },
-    { "Run", Cycle },
-    { "Jog", Jog },
-    { "Home", Homing },
-    { "Door:0", DoorClosed },
-    { "Door:1", DoorOpen },
-    { "Check", CheckMode },
-    { "Sleep", GrblSleep },
-};
-// clang-format on
-
+// Maps the state strings in status reports to internal state enum values.
+// my_state_string is set to a string literal so that scenes can detect a
+// change by comparing pointers.
 bool decode_state_string(const char* state_string, state_t& state) {
-    if (strcmp(my_state_string, state_string) != 0) {
-        auto found = state_map.find(state_string);
-        if (found != state_map.end()) {
-            my_state_string = found->first;
-            state           = found->second;
-            return true;
-        }
+    if (strcmp(my_state_string, state_string) == 0) {
+        return false;
     }
-    return false;
+    const char* name;
+    state_t     new_state;
+    // clang-format off
+    switch (str_hash(state_string)) {
+        case str_hash("Idle"):   name = "Idle";   new_state = Idle;       break;
+        case str_hash("Alarm"):  name = "Alarm";  new_state = Alarm;      break;
+        case str_hash("Hold:0"): name = "Hold:0"; new_state = Hold;       break;
+        case str_hash("Hold:1"): name = "Hold:1"; new_state = Hold;       break;
+        case str_hash("Run"):    name = "Run";    new_state = Cycle;      break;
+        case str_hash("Jog"):    name = "Jog";    new_state = Jog;        break;
+        case str_hash("Home"):   name = "Home";   new_state = Homing;     break;
+        case str_hash("Door:0"): name = "Door:0"; new_state = DoorClosed; break;
+        case str_hash("Door:1"): name = "Door:1"; new_state = DoorOpen;   break;
+        case str_hash("Check"):  name = "Check";  new_state = CheckMode;  break;
+        case str_hash("Sleep"):  name = "Sleep";  new_state = GrblSleep;  break;
+        default: return false;
+    }
+    // clang-format on
+    if (!str_is(state_string, name)) {
+        return false;
+    }
+    my_state_string = name;
+    state           = new_state;
+    return true;
 }
 
 void set_disconnected_state() {
     state           = Disconnected;
     my_state_string = "N/C";
+    protocol_reset_commands();
+    reset_config_requests();  // Their callbacks were dropped with the commands
 }
 
-// clang-format off
-std::map<int, const char*> error_map = {  // Do here so abreviations are right for the dial
-    { 0, "None"},
-    { 1, "GCode letter"},
-    { 2, "GCode format"},
-    { 3, "Bad $ command"},
-    { 4, "Negative value"},
-    { 5, "Setting Diabled"},
-    { 10, "Soft limit error"},
-    { 13, "Check door"},
-    { 18, "No Homing Cycles"},
-    { 20, "Unsupported GCode"},
-    { 22, "Undefined feedrate"},
-    { 19, "No single axis"},
-    { 34, "Arc radius error"},
-    { 39, "P Param Exceeded"},
-};
-// clang-format on
+void reset_fluidnc() {
+    fnc_realtime(Reset);
+    protocol_reset_commands();  // FluidNC will not answer them
+    reset_config_requests();
+}
 
 const char* decode_error_number(int error_num) {
-    if (error_map.find(error_num) != error_map.end()) {
-        return error_map[error_num];
+    // Do here so abreviations are right for the dial
+    // clang-format off
+    switch (error_num) {
+        case 0:  return "None";
+        case 1:  return "GCode letter";
+        case 2:  return "GCode format";
+        case 3:  return "Bad $ command";
+        case 4:  return "Negative value";
+        case 5:  return "Setting Diabled";
+        case 10: return "Soft limit error";
+        case 13: return "Check door";
+        case 18: return "No Homing Cycles";
+        case 19: return "No single axis";
+        case 20: return "Unsupported GCode";
+        case 22: return "Undefined feedrate";
+        case 34: return "Arc radius error";
+        case 39: return "P Param Exceeded";
     }
+    // clang-format on
     static char retval[33];
     sprintf(retval, "%d", error_num);
     return retval;
 }
 
+// The callbacks below fill rx_state as the parser sees the status report,
+// and end_status_report() passes a copy through state_buffer to the UI.
+// Fields that FluidNC reports only occasionally, like overrides, carry over
+// between reports.
+static MachineState               rx_state;
+static TripleBuffer<MachineState> state_buffer;
+static MachineState               ui_state;
+const MachineState&               machine = ui_state;
+
+#ifdef E4_POS_T
+static pos_t mm_to_units(pos_t mm) {
+    return inInches ? e4_mm_to_inch(mm) : mm;
+}
+#else
+static pos_t mm_to_units(pos_t mm) {
+    return inInches ? mm / 25.4 : mm;
+}
+#endif
+
+// Returns true if a new status report was applied
+static bool apply_status() {
+    if (!state_buffer.update()) {
+        return false;
+    }
+    const MachineState& s = state_buffer.front();
+
+    // The parser reports positions in mm.  inInches is set on the UI side,
+    // so the conversion to the current units is done here.
+    pos_t axes[6];
+    for (int axis = 0; axis < 6; axis++) {
+        axes[axis] = mm_to_units(s.axes[axis]);
+    }
+
+    uint16_t changed = 0;
+    if (s.n_axes != ui_state.n_axes) {
+        changed |= MS_N_AXES;
+    }
+    if (memcmp(axes, ui_state.axes, sizeof(axes))) {
+        changed |= MS_AXES;
+    }
+    if (memcmp(s.limits, ui_state.limits, sizeof(s.limits))) {
+        changed |= MS_LIMITS;
+    }
+    if (s.probe != ui_state.probe) {
+        changed |= MS_PROBE;
+    }
+    if (strcmp(s.ctrl_pins, ui_state.ctrl_pins)) {
+        changed |= MS_CTRL_PINS;
+    }
+    if (s.percent != ui_state.percent) {
+        changed |= MS_PERCENT;
+    }
+    if (s.fro != ui_state.fro || s.sro != ui_state.sro) {
+        changed |= MS_OVERRIDES;
+    }
+    if (s.feed != ui_state.feed || s.speed != ui_state.speed) {
+        changed |= MS_FEED_SPEED;
+    }
+
+    uint32_t seq     = ui_state.seq;
+    ui_state         = s;
+    ui_state.seq     = seq + 1;
+    ui_state.changed = changed;
+    memcpy(ui_state.axes, axes, sizeof(axes));
+    return true;
+}
+
 extern "C" void begin_status_report() {
-    myPercent = 0;
+    rx_state.percent = 0;
 }
 
 extern "C" void show_file(const char* filename, file_percent_t percent) {
-    myPercent = percent;
+    rx_state.percent = percent;
 }
 
 extern "C" void show_overrides(override_percent_t feed_ovr, override_percent_t rapid_ovr, override_percent_t spindle_ovr) {
-    myFro = feed_ovr;
-    mySro = spindle_ovr;
+    rx_state.fro = feed_ovr;
+    rx_state.sro = spindle_ovr;
 }
 
 extern "C" void show_feed_spindle(uint32_t feedrate, uint32_t spindle_speed) {
-    myFeed  = feedrate;
-    mySpeed = spindle_speed;
+    rx_state.feed  = feedrate;
+    rx_state.speed = spindle_speed;
 };
 
 extern "C" void show_limits(bool probe, const bool* limits, size_t n_axis) {
-    myProbeSwitch = probe;
-    memcpy(myLimitSwitches, limits, n_axis * sizeof(*limits));
+    rx_state.probe = probe;
+    memcpy(rx_state.limits, limits, n_axis * sizeof(*limits));
 }
 
 extern "C" void show_control_pins(const char* pins) {
     //dbg_printf("show_control_pins:%s\r\n", pins);
-    myCtrlPins = pins;
+    strncpy(rx_state.ctrl_pins, pins, sizeof(rx_state.ctrl_pins) - 1);
 }
 
 #ifdef E4_POS_T
 extern "C" void show_dro(const pos_t* axes, const pos_t* wco, bool isMpos, bool* limits, size_t n_axis) {
-    n_axes = (int)n_axis;
+    rx_state.n_axes = (int)n_axis;
     for (int axis = 0; axis < n_axis; axis++) {
         e4_t axis_val = axes[axis];
         if (isMpos) {
             axis_val -= wco[axis];
         }
-        myAxes[axis] = inInches ? e4_mm_to_inch(axis_val) : axis_val;
+        rx_state.axes[axis] = axis_val;  // Converted to the current units by apply_status()
     }
 }
 #else
@@ -155,28 +217,45 @@ pos_t toMm(pos_t position) {
 }
 
 extern "C" void show_dro(const pos_t* axes, const pos_t* wco, bool isMpos, bool* limits, size_t n_axis) {
+    rx_state.n_axes = (int)n_axis;
     for (int axis = 0; axis < n_axis; axis++) {
-        myAxes[axis] = fromMm(axes[axis]);
+        rx_state.axes[axis] = axes[axis];  // Converted to the current units by apply_status()
         if (isMpos) {
-            myAxes[axis] -= fromMm(wco[axis]);
+            rx_state.axes[axis] -= wco[axis];
         }
     }
 }
 #endif
 
-void send_line(const char* s, int timeout) {
-    fnc_send_line(s, timeout);
+std::atomic<int> lines_in_flight { 0 };
+
+// When the last status report ended; written by the protocol task
+static std::atomic<int> last_report_ms { 0 };
+
+#ifdef AUTO_REPORT
+static void subscribe_reports();
+#endif
+
+void send_line(const char* s, int timeout, const command_done_t& done) {
+    protocol_send_line(s, timeout, done);
+    input_command_sent();
     dbg_println(s);
 }
-static void vsend_linef(const char* fmt, va_list va) {
+static void vsend_linef(int timeout, const char* fmt, va_list va) {
     static char buf[128];
     vsnprintf(buf, 128, fmt, va);
-    send_line(buf);
+    send_line(buf, timeout);
 }
 void send_linef(const char* fmt, ...) {
     va_list args;
     va_start(args, fmt);
-    vsend_linef(fmt, args);
+    vsend_linef(CMD_TIMEOUT_MS, fmt, args);
+    va_end(args);
+}
+void send_linef_timeout(int timeout, const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    vsend_linef(timeout, fmt, args);
     va_end(args);
 }
 
@@ -203,7 +282,7 @@ const char* mode_string() {
 state_t previous_state;
 bool    awaiting_alarm = false;
 
-extern "C" void show_state(const char* state_string) {
+static void ui_show_state(const char* state_string) {
     previous_state = state;
     state_t new_state;
     if (decode_state_string(state_string, new_state) && state != new_state) {
@@ -211,9 +290,13 @@ extern "C" void show_state(const char* state_string) {
             fnc_realtime((realtime_cmd_t)0x0c);  // Ctrl-L - echo off
             send_line("$G");                     // Refresh GCode modes
             send_line("$G");                     // Refresh GCode modes
-            //send_line("$RI=200");
+#ifdef AUTO_REPORT
+            subscribe_reports();
+#endif
             init_file_list();
             detect_homing_info();
+            detect_jog_limits();
+            fetch_config("$/axes");
         }
         state = new_state;
         if (state == Alarm && lastAlarm == 0) {  // Unknown
@@ -225,11 +308,22 @@ extern "C" void show_state(const char* state_string) {
     }
 }
 
-extern "C" void handle_other(char* line) {
+extern "C" void show_state(const char* state_string) {
+    run_on_ui_copy(state_string, [](char* s) { ui_show_state(s); });
+}
+
+static void ui_handle_other(char* line) {
     if (*line == '$') {
         parse_dollar(line);
         return;
     }
+    if (strncmp(line, "Grbl ", strlen("Grbl ")) == 0) {
+        // FluidNC restarted, dropping any commands it had not answered
+        dbg_println("FluidNC Restarted");
+        set_disconnected_state();
+        act_on_state_change();
+        return;
+    }
     int alarmlen = strlen("Active alarm: ");
     if (strncmp(line, "Active alarm: ", alarmlen) == 0) {
         lastAlarm = atoi(line + alarmlen);
@@ -241,27 +335,49 @@ extern "C" void handle_other(char* line) {
     }
 }
 
+extern "C" void handle_other(char* line) {
+    run_on_ui_copy(line, [](char* s) { ui_handle_other(s); });
+}
+
 extern "C" void show_error(int error) {
-    errorExpire = milliseconds() + 1000;
-    lastError   = error;
-    current_scene->reDisplay();
+    commands.complete(error);
+    run_on_ui([error] {
+        errorExpire = milliseconds() + 1000;
+        lastError   = error;
+        request_redraw();
+    });
 }
 
 extern "C" void show_timeout() {
     dbg_println("Timeout");
 }
-extern "C" void show_ok() {}
+extern "C" void show_ok() {
+    commands.complete(0);
+}
 
 extern "C" void end_status_report() {
-    current_scene->onDROChange();
+    last_report_ms      = milliseconds();
+    state_buffer.back() = rx_state;
+    state_buffer.publish();
+    run_on_ui([] {
+        // Scenes update their widgets in place in onDROChange(), which must
+        // wait while a full redraw is pending: that may be the first frame of
+        // a scene just activated, whose widgets still describe its last visit.
+        // The redraw shows the new values anyway.
+        if (apply_status() && !redraw_requested()) {
+            current_scene->onDROChange();
+        }
+    });
 }
 
 extern "C" void show_alarm(int alarm) {
-    lastAlarm = alarm;
-    current_scene->reDisplay();
+    run_on_ui([alarm] {
+        lastAlarm = alarm;
+        request_redraw();
+    });
 }
 
-extern "C" void show_gcode_modes(struct gcode_modes* modes) {
+static void ui_show_gcode_modes(const struct gcode_modes* modes) {
     inInches = strcmp(modes->units, "In") == 0 || strcmp(modes->units, "G20") == 0;
 
     myModes = modes->wcs;
@@ -279,19 +395,65 @@ extern "C" void show_gcode_modes(struct gcode_modes* modes) {
     }
 
     mySelectedTool = modes->tool;
-    current_scene->reDisplay();
+    request_redraw();
+}
+
+extern "C" void show_gcode_modes(struct gcode_modes* modes) {
+#ifdef RX_TASK
+    struct gcode_modes m = *modes;
+    run_on_ui([m] { ui_show_gcode_modes(&m); });
+#else
+    ui_show_gcode_modes(modes);
+#endif
 }
 
-int disconnect_ms = 0;
-int next_ping_ms  = 0;
+// Written by update_rx_time() in the protocol task with -DRX_TASK, and
+// read by fnc_is_connected() in the UI loop
+static std::atomic<int> disconnect_ms { 0 };
+static std::atomic<int> next_ping_ms { 0 };
 
-// If we haven't heard from FluidNC in 0.5 seconds for some other reason,
-// send a status report request.
-const int ping_interval_ms = 500;
+// Status report request intervals.  Reports are requested often while the
+// machine moves and the scene shows it, and rarely when nothing is going on.
+const int status_motion_ms = 80;
+const int status_active_ms = 250;
+const int status_watch_ms  = 500;
+const int status_idle_ms   = 1000;
+
+// User input keeps the rate at status_active_ms for this long
+const int activity_window_ms = 3000;
+
+// After a ping, FluidNC has 2 seconds to respond before we declare it
+// unresponsive.
+const int response_timeout_ms = 2000;
+
+static int last_activity_ms = 0;
+static std::atomic<int> ping_interval_ms { status_watch_ms };
+
+void note_activity() {
+    last_activity_ms = milliseconds();
+}
 
-// If we haven't heard from FluidNC in 2.5 seconds for any reason, declare
-// FluidNC unresponsive.  After a ping, FluidNC has 2 seconds to respond.
-const int disconnect_interval_ms = 2500;
+// Picks the status report interval from the machine state, the scene and
+// how recently the user did something.
+int status_interval() {
+    bool watching = current_scene && current_scene->wantsFastStatus();
+    switch (state) {
+        case Jog:
+        case Cycle:
+        case Homing:
+            return watching ? status_motion_ms : status_active_ms;
+        case Hold:
+        case DoorOpen:
+        case DoorClosed:
+            return status_active_ms;
+        default:
+            break;
+    }
+    if ((milliseconds() - last_activity_ms) < activity_window_ms) {
+        return status_active_ms;
+    }
+    return watching ? status_watch_ms : status_idle_ms;
+}
 
 bool starting = true;
 
@@ -303,28 +465,83 @@ void request_status_report() {
     next_ping_ms = milliseconds() + ping_interval_ms;
 }
 
+#ifdef AUTO_REPORT
+// FluidNC sends status reports on its own every report_interval_ms, and
+// the interval follows status_interval() as the state and scene change.
+// When reports stop, one is requested with '?' in case FluidNC only
+// reports on change; if that goes unanswered too, FluidNC is declared
+// disconnected.
+static int report_interval_ms = 0;  // 0 until subscribed
+static int renegotiate_ms     = 0;
+static int last_probe_ms      = 0;
+
+// Limits how often a changed interval is sent to FluidNC
+const int renegotiate_holdoff_ms = 1000;
+
+static void subscribe_reports() {
+    report_interval_ms = status_interval();
+    renegotiate_ms     = milliseconds() + renegotiate_holdoff_ms;
+    send_linef("$RI=%d", report_interval_ms);
+}
+
 bool fnc_is_connected() {
     int now = milliseconds();
+    if (starting) {
+        starting       = false;
+        last_report_ms = now;
+        request_status_report();
+        return false;
+    }
+
+    int overdue = report_interval_ms * 3;
+    if (overdue < status_idle_ms) {
+        overdue = status_idle_ms;
+    }
+    int quiet = now - last_report_ms;
+    if (quiet >= overdue + response_timeout_ms) {
+        report_interval_ms = 0;
+        last_report_ms     = now - overdue;  // Keep probing until FluidNC answers
+        return false;
+    }
+    if (quiet >= overdue && (now - last_probe_ms) >= overdue) {
+        last_probe_ms = now;
+        request_status_report();
+    }
+
+    if (state != Disconnected && (now - renegotiate_ms) >= 0 && status_interval() != report_interval_ms) {
+        subscribe_reports();
+    }
+    return true;
+}
+#else
+bool fnc_is_connected() {
+    int now          = milliseconds();
+    ping_interval_ms = status_interval();
     if (starting) {
         starting      = false;
-        disconnect_ms = now + (disconnect_interval_ms - ping_interval_ms);
+        disconnect_ms = now + response_timeout_ms;
         request_status_report();  // sets next_ping_ms
         return false;             // Do we need a value for "unknown"?
     }
     if ((now - disconnect_ms) >= 0) {
         next_ping_ms  = now + ping_interval_ms;
-        disconnect_ms = now + disconnect_interval_ms;
+        disconnect_ms = now + ping_interval_ms + response_timeout_ms;
         return false;
     }
 
+    // A shorter interval takes effect now rather than after the current wait
+    if ((next_ping_ms - now) > ping_interval_ms) {
+        next_ping_ms = now + ping_interval_ms;
+    }
     if ((now - next_ping_ms) >= 0) {
         request_status_report();
     }
     return true;
 }
+#endif
 
 void update_rx_time() {
     int now       = milliseconds();
     next_ping_ms  = now + ping_interval_ms;
-    disconnect_ms = now + disconnect_interval_ms;
+    disconnect_ms = now + ping_interval_ms + response_timeout_ms;
 }
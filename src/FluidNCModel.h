@@ -4,6 +4,10 @@
 #pragma once
 #include "GrblParserC.h"
 
+#include "CommandQueue.h"
+
+#include <atomic>
+
 // Same states as FluidNC except for the last one
 enum state_t {
     Idle = 0,   // Must be zero.
@@ -27,27 +31,60 @@ extern state_t     state;
 extern state_t     previous_state;
 extern const char* my_state_string;
 
-extern int                n_axes;
-extern pos_t              myAxes[6];
-extern bool               myLimitSwitches[6];
-extern bool               myProbeSwitch;
-extern const char*        myCtrlPins;
-extern const char*        myFile;
-extern file_percent_t     myPercent;
-extern override_percent_t myFro;
-extern override_percent_t mySro;
-extern uint32_t           myFeed;
-extern uint32_t           mySpeed;
-extern int                lastAlarm;
-extern int                lastError;
-extern uint32_t           errorExpire;
-extern bool               inInches;
-extern uint32_t           mySelectedTool;
+// Bits in MachineState::changed
+enum machine_field_t : uint16_t {
+    MS_N_AXES     = 1 << 0,
+    MS_AXES       = 1 << 1,
+    MS_LIMITS     = 1 << 2,
+    MS_PROBE      = 1 << 3,
+    MS_CTRL_PINS  = 1 << 4,
+    MS_PERCENT    = 1 << 5,
+    MS_OVERRIDES  = 1 << 6,
+    MS_FEED_SPEED = 1 << 7,
+};
+
+// The fields that status reports carry.  The UI reads them from machine,
+// which is replaced as a whole once per status report, just before
+// onDROChange().  seq counts the replacements and changed marks the fields
+// that differ from the previous one, so a scene can skip work that does not
+// depend on what changed.  The run state stays in state, above, because
+// changing it drives scene transitions.
+struct MachineState {
+    uint32_t seq     = 0;
+    uint16_t changed = 0;
+
+    int                n_axes        = 3;
+    pos_t              axes[6]       = { 0 };  // Work position in the current units
+    bool               limits[6]     = { false };
+    bool               probe         = false;
+    char               ctrl_pins[16] = "";
+    file_percent_t     percent       = 0;    // percent complete of SD file
+    override_percent_t fro           = 100;  // Feed rate override
+    override_percent_t sro           = 100;  // Spindle override
+    uint32_t           feed          = 0;
+    uint32_t           speed         = 0;
+};
+
+extern const MachineState& machine;
+
+extern int      lastAlarm;
+extern int      lastError;
+extern uint32_t errorExpire;
+extern bool     inInches;
+extern uint32_t mySelectedTool;
 
 int num_digits();
 
-void send_line(const char* s, int timeout = 2000);
+// Lines queued for FluidNC that have not yet been answered with ok or error
+extern std::atomic<int> lines_in_flight;
+
+// Queues a line for FluidNC without waiting.  done, if given, is called
+// with 0 for ok, N for error:N or CMD_TIMEOUT if there is no answer
+// within timeout ms.  Commands that are answered only when motion ends
+// should pass CMD_NO_TIMEOUT.
+void send_line(const char* s, int timeout = CMD_TIMEOUT_MS, const command_done_t& done = nullptr);
 void send_linef(const char* fmt, ...);
+void send_linef_timeout(int timeout, const char* fmt, ...);
 
 const char* intToCStr(int val);
 const char* axisNumToCStr(int axis);
@@ -60,7 +97,14 @@ const char* mode_string();
 bool fnc_is_connected();
 void set_disconnected_state();
 
+// Sends a ^X reset, which discards the commands FluidNC has not answered
+void reset_fluidnc();
+
 void update_rx_time();
 
+// Records user input, which raises the status report rate for a while
+void note_activity();
+int  status_interval();
+
 extern pos_t toMm(pos_t position);
 extern pos_t fromMm(pos_t position);
@@ -0,0 +1,363 @@
+// Copyright (c) 2024 - Mitch Bradley
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "GCodePreview.h"
+
+#include <math.h>
+#include <string.h>
+
+static const int64_t INITIAL_CELL = 1000;               // 0.1 mm
+static const int64_t MAX_CELL     = 1000000000LL / 64;  // Stop growing past a ~200 m work area
+
+void GCodePreview::clear_bits() {
+    memset(_bits, 0, sizeof(_bits));
+    _min_x = _min_y = GRID;
+    _max_x = _max_y = -1;
+}
+
+void GCodePreview::reset() {
+    clear_bits();
+    _empty      = true;
+    _generation = 0;
+    _cell       = INITIAL_CELL;
+    _origin_x   = 0;
+    _origin_y   = 0;
+    _x          = 0;
+    _y          = 0;
+    _motion     = 0;
+    _relative   = false;
+    _inches     = false;
+    _lines      = 0;
+}
+
+void GCodePreview::set_cell(int cx, int cy) {
+    if (cx >= 0 && cx < GRID && cy >= 0 && cy < GRID) {
+        _bits[(cy * GRID + cx) / 32] |= 1u << (cx & 31);
+        if (cx < _min_x) {
+            _min_x = cx;
+        }
+        if (cx > _max_x) {
+            _max_x = cx;
+        }
+        if (cy < _min_y) {
+            _min_y = cy;
+        }
+        if (cy > _max_y) {
+            _max_y = cy;
+        }
+    }
+}
+
+// Make the grid cover (x, y), doubling the cell size as often as necessary.
+// On each doubling the old area becomes one quadrant of the new one, the
+// quadrant chosen so that the grid grows toward the point.
+void GCodePreview::grow_to(int64_t x, int64_t y) {
+    if (_empty) {
+        _empty    = false;
+        _origin_x = x - _cell * GRID / 2;
+        _origin_y = y - _cell * GRID / 2;
+    }
+    while ((x < _origin_x || x >= _origin_x + _cell * GRID || y < _origin_y || y >= _origin_y + _cell * GRID) && _cell < MAX_CELL) {
+        int shift_x = x < _origin_x ? GRID : 0;
+        int shift_y = y < _origin_y ? GRID : 0;
+
+        static uint32_t old_bits[GRID * GRID / 32];  // Too big for the stack
+        memcpy(old_bits, _bits, sizeof(_bits));
+        clear_bits();
+        for (int cy = 0; cy < GRID; cy++) {
+            for (int cx = 0; cx < GRID; cx++) {
+                if (old_bits[(cy * GRID + cx) / 32] & (1u << (cx & 31))) {
+                    set_cell((cx + shift_x) / 2, (cy + shift_y) / 2);
+                }
+            }
+        }
+        _origin_x -= shift_x * _cell;
+        _origin_y -= shift_y * _cell;
+        _cell *= 2;
+        ++_generation;
+    }
+}
+
+// Region code of a point against the grid rectangle [lo, hi)
+static int outcode(int64_t x, int64_t y, int64_t lo_x, int64_t lo_y, int64_t hi_x, int64_t hi_y) {
+    return (x < lo_x ? 1 : x >= hi_x ? 2 : 0) | (y < lo_y ? 4 : y >= hi_y ? 8 : 0);
+}
+
+// Moves (x0, y0) along the segment toward (x1, y1) until it is inside the
+// rectangle, by bisection, so no products of wide coordinates are needed.
+// Returns false if the segment misses the rectangle.
+static bool clip_end(int64_t& x0, int64_t& y0, int64_t x1, int64_t y1, int64_t lo_x, int64_t lo_y, int64_t hi_x, int64_t hi_y) {
+    int code0 = outcode(x0, y0, lo_x, lo_y, hi_x, hi_y);
+    if (code0 == 0) {
+        return true;
+    }
+    // The point nearest (ax, ay) that is inside lies between a and b
+    int64_t ax = x0, ay = y0, bx = x1, by = y1;
+    for (int n = 0; n < 64; n++) {
+        int64_t mx = (ax >> 1) + (bx >> 1);  // Cannot overflow
+        int64_t my = (ay >> 1) + (by >> 1);
+        if ((mx == ax && my == ay) || (mx == bx && my == by)) {
+            break;
+        }
+        if (code0 & outcode(mx, my, lo_x, lo_y, hi_x, hi_y)) {
+            ax    = mx;  // a..m is entirely outside one edge
+            ay    = my;
+            code0 = outcode(ax, ay, lo_x, lo_y, hi_x, hi_y);
+        } else {
+            bx = mx;
+            by = my;
+        }
+    }
+    if (outcode(bx, by, lo_x, lo_y, hi_x, hi_y)) {
+        return false;
+    }
+    x0 = bx;
+    y0 = by;
+    return true;
+}
+
+static int to_cell(int64_t v, int64_t origin, int64_t cell) {
+    int64_t c = (v - origin) / cell;  // v is inside the grid, so this is not negative
+    return c >= GCodePreview::GRID ? GCodePreview::GRID - 1 : (int)c;
+}
+
+void GCodePreview::rasterize(int64_t x0, int64_t y0, int64_t x1, int64_t y1) {
+    grow_to(x0, y0);
+    grow_to(x1, y1);
+
+    // Once the cell size reaches MAX_CELL the grid stops growing, and a
+    // wild coordinate can lie far outside it.  Only the part of the move
+    // inside the grid is stepped, so the loop below is at most 2 * GRID long.
+    int64_t hi_x = _origin_x + _cell * GRID;
+    int64_t hi_y = _origin_y + _cell * GRID;
+    if (outcode(x0, y0, _origin_x, _origin_y, hi_x, hi_y) & outcode(x1, y1, _origin_x, _origin_y, hi_x, hi_y)) {
+        return;
+    }
+    if (!clip_end(x0, y0, x1, y1, _origin_x, _origin_y, hi_x, hi_y) || !clip_end(x1, y1, x0, y0, _origin_x, _origin_y, hi_x, hi_y)) {
+        return;
+    }
+
+    int cx0 = to_cell(x0, _origin_x, _cell);
+    int cy0 = to_cell(y0, _origin_y, _cell);
+    int cx1 = to_cell(x1, _origin_x, _cell);
+    int cy1 = to_cell(y1, _origin_y, _cell);
+
+    // Bresenham
+    int dx  = cx1 > cx0 ? cx1 - cx0 : cx0 - cx1;
+    int dy  = cy1 > cy0 ? cy0 - cy1 : cy1 - cy0;
+    int sx  = cx0 < cx1 ? 1 : -1;
+    int sy  = cy0 < cy1 ? 1 : -1;
+    int err = dx + dy;
+    while (true) {
+        set_cell(cx0, cy0);
+        if (cx0 == cx1 && cy0 == cy1) {
+            break;
+        }
+        int e2 = 2 * err;
+        if (e2 >= dy) {
+            err += dy;
+            cx0 += sx;
+        }
+        if (e2 <= dx) {
+            err += dx;
+            cy0 += sy;
+        }
+    }
+}
+
+// Arc from the current position to (x1, y1) around the center at offset
+// (i, j), flattened into chords no longer than about one cell.  The ESP32
+// has a single precision FPU, so the arc is worked out in float relative to
+// its center, and the chord endpoints come from rotating the radius vector
+// rather than from a sin and cos per chord.
+void GCodePreview::arc(int64_t x1, int64_t y1, int64_t i, int64_t j, bool cw) {
+    int64_t cx     = _x + i;
+    int64_t cy     = _y + j;
+    float   radius = sqrtf((float)i * (float)i + (float)j * (float)j);
+    float   start  = atan2f(-(float)j, -(float)i);
+    float   end    = atan2f((float)(y1 - cy), (float)(x1 - cx));
+    float   sweep  = end - start;
+    if (cw) {
+        if (sweep >= 0) {
+            sweep -= 2 * (float)M_PI;
+        }
+    } else {
+        if (sweep <= 0) {
+            sweep += 2 * (float)M_PI;
+        }
+    }
+    grow_to(x1, y1);
+    float length   = fabsf(sweep) * radius / (float)_cell;
+    int   segments = length < 4 * GRID ? (int)length + 1 : 4 * GRID;
+
+    float step_cos = cosf(sweep / segments);
+    float step_sin = sinf(sweep / segments);
+    float vx       = -(float)i;  // From the center to the current point
+    float vy       = -(float)j;
+    int64_t px     = _x;
+    int64_t py     = _y;
+    for (int n = 1; n <= segments; n++) {
+        int64_t nx, ny;
+        if (n == segments) {
+            nx = x1;
+            ny = y1;
+        } else {
+            float rx = vx * step_cos - vy * step_sin;
+            vy       = vx * step_sin + vy * step_cos;
+            vx       = rx;
+            nx       = cx + (int64_t)vx;
+            ny       = cy + (int64_t)vy;
+        }
+        rasterize(px, py, nx, ny);
+        px = nx;
+        py = ny;
+    }
+}
+
+bool GCodePreview::bounds(int& min_x, int& min_y, int& max_x, int& max_y) const {
+    min_x = _min_x;
+    min_y = _min_y;
+    max_x = _max_x;
+    max_y = _max_y;
+    return max_x >= 0;
+}
+
+// Parses a decimal number into e4 units, advancing *s past it
+static int64_t parse_e4(const char** s) {
+    const char* p        = *s;
+    bool        negative = false;
+    if (*p == '-' || *p == '+') {
+        negative = *p++ == '-';
+    }
+    int64_t value = 0;
+    while (*p >= '0' && *p <= '9') {
+        value = value * 10 + (*p++ - '0');
+    }
+    value *= 10000;
+    if (*p == '.') {
+        ++p;
+        int64_t scale = 1000;
+        while (*p >= '0' && *p <= '9') {
+            value += (*p++ - '0') * scale;
+            scale /= 10;
+        }
+    }
+    *s = p;
+    return negative ? -value : value;
+}
+
+void GCodePreview::parseLine(const char* line) {
+    ++_lines;
+
+    bool    have_x = false, have_y = false, have_r = false;
+    int64_t x = 0, y = 0, i = 0, j = 0, r = 0;
+    int     motion = _motion;
+
+    const char* p = line;
+    while (*p) {
+        char c = *p++;
+        if (c == '(') {
+            while (*p && *p++ != ')') {}
+            continue;
+        }
+        if (c == ';' || c == '%') {
+            break;
+        }
+        if (c >= 'a' && c <= 'z') {
+            c -= 'a' - 'A';
+        }
+        if (c < 'A' || c > 'Z') {
+            continue;
+        }
+        while (*p == ' ') {
+            ++p;
+        }
+        int64_t value = parse_e4(&p);
+        switch (c) {
+            case 'G':
+                switch (value) {
+                    case 0:
+                    case 10000:
+                    case 20000:
+                    case 30000:
+                        motion = value / 10000;
+                        break;
+                    case 200000:
+                        _inches = true;
+                        break;
+                    case 210000:
+                        _inches = false;
+                        break;
+                    case 900000:
+                        _relative = false;
+                        break;
+                    case 910000:
+                        _relative = true;
+                        break;
+                }
+                break;
+            case 'X':
+                x      = value;
+                have_x = true;
+                break;
+            case 'Y':
+                y      = value;
+                have_y = true;
+                break;
+            case 'I':
+                i = value;
+                break;
+            case 'J':
+                j = value;
+                break;
+            case 'R':
+                r      = value;
+                have_r = true;
+                break;
+        }
+    }
+    _motion = motion;
+
+    if (!have_x && !have_y) {
+        return;
+    }
+    if (_inches) {
+        x = x * 254 / 10;
+        y = y * 254 / 10;
+        i = i * 254 / 10;
+        j = j * 254 / 10;
+        r = r * 254 / 10;
+    }
+    int64_t nx = have_x ? (_relative ? _x + x : x) : _x;
+    int64_t ny = have_y ? (_relative ? _y + y : y) : _y;
+
+    switch (_motion) {
+        case 0:
+            // Rapids are not part of the toolpath
+            break;
+        case 1:
+            rasterize(_x, _y, nx, ny);
+            break;
+        case 2:
+        case 3:
+            if (have_r) {
+                // Radius format: find the center on the perpendicular bisector of the chord
+                float dx = (float)(nx - _x);
+                float dy = (float)(ny - _y);
+                float d2 = dx * dx + dy * dy;
+                float rr = (float)r;
+                float h  = rr * rr - d2 / 4;
+                h        = h > 0 && d2 > 0 ? sqrtf(h / d2) : 0;
+                // Negative R selects the longer arc
+                if ((_motion == 2) == (r > 0)) {
+                    h = -h;
+                }
+                i = (int64_t)(dx / 2 - h * dy);
+                j = (int64_t)(dy / 2 + h * dx);
+            }
+            arc(nx, ny, i, j, _motion == 2);
+            break;
+    }
+    _x = nx;
+    _y = ny;
+}
@@ -0,0 +1,84 @@
+// Copyright (c) 2024 - Mitch Bradley
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+// Toolpath preview for G-code files of any size.  Lines are fed through a
+// small interpreter that understands G0/G1/G2/G3, G90/G91 and G20/G21, and
+// the XY path of the cutting moves is recorded in a fixed-size occupancy
+// bitmap.  The bitmap starts with fine cells around the first move.  When a
+// move goes outside it, the cell size doubles and the existing cells are
+// merged 2x2, so memory use stays the same however large the file or the
+// work area is.
+//
+// This has no display or FluidNC dependencies so it can be exercised on a
+// host by feeding it lines from a file; see test/test_gcode_preview.
+//
+// Positions are e4 mm integers throughout, as the ESP32 has no double
+// precision FPU.  Only arcs use float, relative to their centers.
+
+#pragma once
+
+#include "e4math.h"
+#include <stdint.h>
+
+class GCodePreview {
+public:
+    static const int GRID = 128;  // cells on a side
+
+private:
+    uint32_t _bits[GRID * GRID / 32];
+
+    bool    _empty;
+    int     _generation;  // Counts the cell size doublings
+    int64_t _cell;        // cell size, e4 mm
+    int64_t _origin_x;
+    int64_t _origin_y;
+
+    // Interpreter state, positions in e4 mm
+    int64_t _x;
+    int64_t _y;
+    int     _motion;
+    bool    _relative;
+    bool    _inches;
+
+    int _lines;
+
+    // The range of occupied cells, kept up to date by set_cell()
+    int _min_x;
+    int _min_y;
+    int _max_x;
+    int _max_y;
+
+    void clear_bits();
+
+    void set_cell(int cx, int cy);
+    void grow_to(int64_t x, int64_t y);
+    void rasterize(int64_t x0, int64_t y0, int64_t x1, int64_t y1);
+    void arc(int64_t x1, int64_t y1, int64_t i, int64_t j, bool cw);
+
+public:
+    GCodePreview() { reset(); }
+
+    void reset();
+    void parseLine(const char* line);
+
+    int  lines() const { return _lines; }
+    bool empty() const { return _empty; }
+
+    // Cell (cx, cy), with cy increasing in the +Y direction
+    bool cell(int cx, int cy) const { return _bits[(cy * GRID + cx) / 32] & (1u << (cx & 31)); }
+
+    // The cells as 32-bit words, so a display can find the cells set since
+    // it last looked.  Bit b of word n is cell (n % (GRID / 32) * 32 + b,
+    // n / (GRID / 32)).
+    static const int WORDS = GRID * GRID / 32;
+    uint32_t         word(int n) const { return _bits[n]; }
+
+    // Changes whenever the grid is rescaled, which moves every cell
+    int generation() const { return _generation; }
+
+    // The range of occupied cells, inclusive.  Returns false if there are none.
+    bool bounds(int& min_x, int& min_y, int& max_x, int& max_y) const;
+
+    // The width of a cell, e4 mm
+    e4_t cellSize() const { return (e4_t)_cell; }
+};
@@ -12,6 +12,7 @@
 #include "Hardware2432.hpp"
 #include "Drawing.h"
 #include "NVS.h"
+#include "InputQueue.h"
 
 #include <driver/uart.h>
 #include "hal/uart_hal.h"
@@ -312,6 +313,7 @@ void  set_layout(int n) {
      layout = &layouts[n];
      display.setRotation(layout->rotation());
      sprite_offset = layout->spritePosition;
+     invalidateDisplay();
 }
 
 nvs_handle_t hw_nvs;
@@ -452,6 +454,33 @@ void initLockIcons() {
     drawPngFile(lock_icon, "lock_icon.png", 0, 0);
 }
 
+static int* const button_pins[n_buttons] = { &red_button_pin, &dial_button_pin, &green_button_pin };
+
+// GPIO interrupts on one core do not preempt each other, so the button
+// handlers together are the single producer for button_events.
+static void IRAM_ATTR button_isr(void* arg) {
+    int           button = (int)(intptr_t)arg;
+    input_event_t event;
+    event.ms     = millis();
+    event.value  = !gpio_get_level((gpio_num_t)*button_pins[button]);  // Active low
+    event.button = button;
+    event.type   = BUTTON_EVENT;
+
+    button_level_ms[button] = event.ms;
+    button_levels[button]   = event.value;
+    button_events.push(event);
+}
+
+static void init_button_interrupts() {
+    for (int i = 0; i < n_buttons; i++) {
+        int pin = *button_pins[i];
+        if (pin != -1) {
+            pinMode(pin, INPUT_PULLUP);
+            attachInterruptArg(pin, button_isr, (void*)(intptr_t)i, CHANGE);
+        }
+    }
+}
+
 void init_hardware() {
 #ifdef DEBUG_TO_USB
     Serial.begin(115200);
@@ -479,6 +508,7 @@ void init_hardware() {
     touch.begin(&display);
 
     init_encoder(enc_a, enc_b);
+    init_button_interrupts();
     init_fnc_uart(FNC_UART_NUM, PND_TX_FNC_RX_PIN, PND_RX_FNC_TX_PIN);
 
     touch.setFlickThresh(10);
@@ -538,42 +568,13 @@ void next_layout(int delta) {
     drawLockIcons(last_locked);
 }
 
+// Does not mark the canvas dirty; Scene::paintBackground() relies on that
 void system_background() {
-    drawBackground(BLACK);
+    canvas.fillSprite(BLACK);
 }
 
+// The switches are reported by button_isr() through button_events
 bool switch_button_touched(bool& pressed, int& button) {
-    static int last_red   = -1;
-    static int last_green = -1;
-    static int last_dial  = -1;
-    bool       state;
-    if (red_button_pin != -1) {
-        state = digitalRead(red_button_pin);
-        if ((int)state != last_red) {
-            last_red = state;
-            button   = 0;
-            pressed  = !state;
-            return true;
-        }
-    }
-    if (dial_button_pin != -1) {
-        state = digitalRead(dial_button_pin);
-        if ((int)state != last_dial) {
-            last_dial = state;
-            button    = 1;
-            pressed   = !state;
-            return true;
-        }
-    }
-    if (green_button_pin != -1) {
-        state = digitalRead(green_button_pin);
-        if ((int)state != last_green) {
-            last_green = state;
-            button     = 2;
-            pressed    = !state;
-            return true;
-        }
-    }
     return false;
 }
 
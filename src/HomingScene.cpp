@@ -2,6 +2,7 @@
 // Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
 
 #include "Scene.h"
+#include "Widget.h"
 #include "ConfigItem.h"
 
 extern Scene statusScene;
@@ -25,13 +26,13 @@ bool is_homed(int axis) {
 }
 void set_axis_homed(int axis) {
     homed_axes |= 1 << axis;
-    current_scene->reDisplay();
+    request_redraw();
 }
 
 void detect_homing_info() {
     for (int i = 0; i < HOMING_N_AXIS; i++) {
-        homing_cycles[i].init();
-        homing_allows[i].init();
+        homing_cycles[i].expect();
+        homing_allows[i].expect();
     }
     homed_axes = 0;
 }
@@ -51,9 +52,20 @@ private:
 
     bool _allows[HOMING_N_AXIS];
 
+    DROWidget _dros[HOMING_N_AXIS] = { { 16, 68, 210, 32, 0 }, { 16, 101, 210, 32, 1 }, { 16, 134, 210, 32, 2 } };
+
+    // Set when the last full redraw showed the DROs in the current state
+    bool    _dros_shown  = false;
+    state_t _shown_state = Idle;
+    bool    _shown_door  = false;
+
+    bool door_active() { return strchr(machine.ctrl_pins, 'D') != NULL; }
+
 public:
     HomingScene() : Scene("Home", 4) {}
 
+    bool wantsFastStatus() override { return true; }
+
     bool is_homing(int axis) { return can_home(axis) && (_axis_to_home == -1 || _axis_to_home == axis); }
     void onEntry(void* arg) override {
         if (state == Idle && _auto) {
@@ -74,9 +86,9 @@ public:
     void onGreenButtonPress() override {
         if (state == Idle || state == Alarm) {
             if (_axis_to_home != -1) {
-                send_linef("$H%c", axisNumToChar(_axis_to_home));
+                send_linef_timeout(CMD_NO_TIMEOUT, "$H%c", axisNumToChar(_axis_to_home));
             } else {
-                send_line("$H");
+                send_line("$H", CMD_NO_TIMEOUT);
             }
         } else if (state == Cycle) {
             fnc_realtime(FeedHold);
@@ -86,7 +98,7 @@ public:
     }
     void onRedButtonPress() override {
         if (state == Homing || state == Alarm) {
-            fnc_realtime(Reset);
+            reset_fluidnc();
         }
     }
 
@@ -102,16 +114,27 @@ public:
     void onTouchClick() {
         if (state == Idle || state == Homing || state == Alarm) {
             increment_axis_to_home();
-            reDisplay();
+            request_redraw();
             ackBeep();
         }
     }
 
     void onEncoder(int delta) override {
         increment_axis_to_home();
-        reDisplay();
+        request_redraw();
+    }
+    void onDROChange() {
+        // Any status change that affects the legends needs a full redraw
+        if (!_dros_shown || state != _shown_state || door_active() != _shown_door) {
+            request_redraw();
+            return;
+        }
+        for (int axis = 0; axis < HOMING_N_AXIS; ++axis) {
+            _dros[axis].setHoming(is_homing(axis), is_homed(axis));
+            _dros[axis].update();
+        }
+        refreshDisplay();
     }
-    void onDROChange() { reDisplay(); }  // also covers any status change
 
     void reDisplay() {
         background();
@@ -123,6 +146,10 @@ public:
         const char* orangeLabel = "";
         std::string green       = "Home ";
 
+        _dros_shown  = false;
+        _shown_state = state;
+        _shown_door  = door_active();
+
         if (false && state == Homing) {
             DRO dro(16, 68, 210, 32);
             for (size_t axis = 0; axis < HOMING_N_AXIS; axis++) {
@@ -130,10 +157,11 @@ public:
             }
 
         } else if (state == Idle || state == Homing || state == Alarm) {
-            DRO dro(16, 68, 210, 32);
             for (int axis = 0; axis < HOMING_N_AXIS; ++axis) {
-                dro.drawHoming(axis, is_homing(axis), is_homed(axis));
+                _dros[axis].setHoming(is_homing(axis), is_homed(axis));
+                _dros[axis].draw();
             }
+            _dros_shown = true;
 
 #if 0
             int x      = 50;
@@ -148,15 +176,15 @@ public:
             button.draw("Home Y", _axis_to_home == 1);
             button.draw("Home Z", _axis_to_home == 2);
             LED led(x - 16, y + height / 2, 10, button.gap());
-            led.draw(myLimitSwitches[0]);
-            led.draw(myLimitSwitches[1]);
-            led.draw(myLimitSwitches[2]);
+            led.draw(machine.limits[0]);
+            led.draw(machine.limits[1]);
+            led.draw(machine.limits[2]);
 #endif
 
             if (state == Homing) {
                 redLabel = "E-Stop";
             } else {
-                if (state == Alarm && (strchr(myCtrlPins, 'D') == NULL)) {  // You can reset alarms if door is not active
+                if (state == Alarm && !door_active()) {  // You can reset alarms if door is not active
                     redLabel = "Reset";
                 }
                 if (_axis_to_home == -1) {
@@ -1,2 +1,3 @@
+// Registers the homing settings to be picked up by fetch_config("$/axes")
 extern void detect_homing_info();
 extern void set_axis_homed(int axis);
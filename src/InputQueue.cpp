@@ -0,0 +1,48 @@
+// Copyright (c) 2024 - Mitch Bradley
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "InputQueue.h"
+#include "GrblParserC.h"  // milliseconds()
+
+SpscQueue<input_event_t, 32> encoder_events;
+SpscQueue<input_event_t, 32> button_events;
+
+std::atomic<bool>     button_levels[3];
+std::atomic<uint32_t> button_level_ms[3];
+
+static bool     latency_pending = false;
+static uint32_t latency_start   = 0;
+static uint32_t latency_max     = 0;
+static uint32_t latency_avg     = 0;  // Exponential average, scaled by 8
+static uint32_t latency_samples = 0;
+
+void input_dispatched(uint32_t event_ms) {
+    if (!latency_pending) {
+        latency_pending = true;
+        latency_start   = event_ms;
+    }
+}
+
+void input_command_sent() {
+    if (!latency_pending) {
+        return;
+    }
+    latency_pending  = false;
+    uint32_t latency = milliseconds() - latency_start;
+    if (latency > latency_max) {
+        latency_max = latency;
+    }
+    latency_avg = latency_samples ? latency_avg - latency_avg / 8 + latency : latency * 8;
+    ++latency_samples;
+}
+
+void input_pass_done() {
+    latency_pending = false;
+}
+
+void input_stats(uint32_t& max_latency_ms, uint32_t& avg_latency_ms, uint32_t& samples, uint32_t& dropped) {
+    max_latency_ms = latency_max;
+    avg_latency_ms = latency_avg / 8;
+    samples        = latency_samples;
+    dropped        = encoder_events.dropped() + button_events.dropped();
+}
@@ -0,0 +1,77 @@
+// Copyright (c) 2024 - Mitch Bradley
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+// Input events posted from interrupt handlers and drained by dispatch_events().
+// Each event is timestamped when it happens, so a slow redraw delays its
+// handling but does not lose it or distort the encoder speed estimate.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Lock-free queue for exactly one producer and one consumer.  N must be a
+// power of two.  One slot is kept empty to tell full from empty.
+template <typename T, size_t N>
+class SpscQueue {
+    static_assert((N & (N - 1)) == 0, "SpscQueue size must be a power of two");
+
+    T                   _items[N];
+    std::atomic<size_t> _head { 0 };  // Next slot to read, owned by the consumer
+    std::atomic<size_t> _tail { 0 };  // Next slot to write, owned by the producer
+    std::atomic<size_t> _dropped { 0 };
+
+public:
+    bool push(const T& item) {
+        size_t tail = _tail.load(std::memory_order_relaxed);
+        size_t next = (tail + 1) & (N - 1);
+        if (next == _head.load(std::memory_order_acquire)) {
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        _items[tail] = item;
+        _tail.store(next, std::memory_order_release);
+        return true;
+    }
+    bool pop(T& item) {
+        size_t head = _head.load(std::memory_order_relaxed);
+        if (head == _tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = _items[head];
+        _head.store((head + 1) & (N - 1), std::memory_order_release);
+        return true;
+    }
+    size_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+};
+
+enum input_type_t : uint8_t {
+    ENCODER_EVENT,  // value is the encoder count after the change
+    BUTTON_EVENT,   // value is 1 for pressed, 0 for released
+};
+
+struct input_event_t {
+    uint32_t     ms;
+    int16_t      value;
+    uint8_t      button;
+    input_type_t type;
+};
+
+// Each queue has a single interrupt source as its producer
+extern SpscQueue<input_event_t, 32> encoder_events;
+extern SpscQueue<input_event_t, 32> button_events;
+
+// The latest level and time of each switch, stored by the interrupt handler
+// even when button_events is full, so a bounce burst that overflows the
+// queue cannot lose the level the switch settled at.
+extern std::atomic<bool>     button_levels[3];
+extern std::atomic<uint32_t> button_level_ms[3];
+
+// Event-to-command latency: dispatch_events() notes when the event it is
+// handling happened, and a command sent to FluidNC in the same pass takes a
+// sample.  input_pass_done() drops the note if no command was sent.
+void input_dispatched(uint32_t event_ms);
+void input_command_sent();
+void input_pass_done();
+void input_stats(uint32_t& max_latency_ms, uint32_t& avg_latency_ms, uint32_t& samples, uint32_t& dropped);
@@ -0,0 +1,136 @@
+// Copyright (c) 2024 - Mitch Bradley
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "JogStreamer.h"
+#include "ConfigItem.h"
+
+#include <string>
+
+static IntConfigItem max_rates[] = {
+    { "$/axes/x/max_rate_mm_per_min" },
+    { "$/axes/y/max_rate_mm_per_min" },
+    { "$/axes/z/max_rate_mm_per_min" },
+};
+
+void detect_jog_limits() {
+    for (auto& rate : max_rates) {
+        rate.expect();
+    }
+}
+
+void JogStreamer::reset() {
+    _pending      = 0;
+    _queued_until = 0;
+    _in_flight    = 0;
+    ++_generation;
+}
+
+void JogStreamer::add(int detents) {
+    if (_pending == 0) {
+        _window_start = milliseconds();
+    } else if ((_pending < 0) != (detents < 0)) {
+        // Reversing the dial discards what has not been sent
+        _pending      = 0;
+        _window_start = milliseconds();
+    }
+    _pending += detents;
+}
+
+// Maximum feed rate in the current units, e4 per minute.  The slowest
+// jogging axis limits the move, if FluidNC has told us its max rate.
+e4_t JogStreamer::max_feed() {
+    int mm_per_min = JOG_MAX_FEED;
+    for (int axis = 0; axis < MAX_AXES; axis++) {
+        if (_step[axis] && max_rates[axis].known() && max_rates[axis].get() > 0 && max_rates[axis].get() < mm_per_min) {
+            mm_per_min = max_rates[axis].get();
+        }
+    }
+    e4_t feed = e4_from_int(mm_per_min);
+    return inInches ? e4_mm_to_inch(feed) : feed;
+}
+
+void JogStreamer::send() {
+    int now = milliseconds();
+
+    // Length of one detent along the combined direction of the jogging axes
+    e4_t step = 0;
+    for (int axis = 0; axis < MAX_AXES; axis++) {
+        if (_step[axis]) {
+            step = e4_magnitude(step, _step[axis]);
+        }
+    }
+    if (step == 0) {
+        _pending = 0;
+        return;
+    }
+
+    // The dial speed over the window gives the feed rate.  Slow turning is
+    // still done at a rate that finishes each segment in JOG_MAX_SEGMENT_MS.
+    int elapsed = now - _window_start;
+    if (elapsed < JOG_WINDOW_MS) {
+        elapsed = JOG_WINDOW_MS;
+    }
+    if (elapsed > JOG_MAX_SEGMENT_MS) {
+        elapsed = JOG_MAX_SEGMENT_MS;
+    }
+    int     detents = _pending < 0 ? -_pending : _pending;
+    int64_t length  = (int64_t)detents * step;
+    int64_t feed    = length * 60000 / elapsed;
+
+    // Drop detents that would take too long at the fastest feed
+    int64_t fastest = max_feed();
+    if (feed > fastest) {
+        feed         = fastest;
+        int max_dets = fastest * JOG_MAX_SEGMENT_MS / 60000 / step;
+        if (max_dets < 1) {
+            max_dets = 1;
+        }
+        if (detents > max_dets) {
+            detents = max_dets;
+            length  = (int64_t)detents * step;
+        }
+    }
+    int sign = _pending < 0 ? -1 : 1;
+
+    // e.g. $J=G91F1000X-10000
+    std::string cmd("$J=G91F");
+    int whole_feed = feed / 10000;
+    cmd += std::to_string(whole_feed ? whole_feed : 1);
+    for (int axis = 0; axis < MAX_AXES; axis++) {
+        if (_step[axis]) {
+            cmd += axisNumToChar(axis);
+            cmd += e4_to_cstr(sign * detents * _step[axis], inInches ? 3 : 2);
+        }
+    }
+    ++_in_flight;
+    int generation = _generation;
+    send_line(cmd.c_str(), CMD_TIMEOUT_MS, [this, generation](int, int) {
+        if (generation == _generation && _in_flight > 0) {
+            --_in_flight;
+        }
+    });
+
+    int duration  = length * 60000 / feed;
+    _queued_until = (_queued_until > now ? _queued_until : now) + duration;
+    _last_send    = now;
+    _pending      = 0;
+}
+
+void JogStreamer::poll() {
+    if (_pending == 0) {
+        return;
+    }
+    int now = milliseconds();
+    if (now - _window_start < JOG_WINDOW_MS) {
+        return;
+    }
+    // An ok that never came should not stop jogging for good
+    if (_in_flight >= JOG_MAX_IN_FLIGHT && now - _last_send < 1000) {
+        return;
+    }
+    if (_queued_until - now > JOG_WINDOW_MS) {
+        // Enough is queued already; keep collecting
+        return;
+    }
+    send();
+}
@@ -0,0 +1,65 @@
+// Copyright (c) 2024 - Mitch Bradley
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+// MPG jogging from the encoder.  Detents are collected over a short window
+// and sent as one $J= segment whose feed rate matches how fast the dial is
+// turning.  A segment is only sent when FluidNC has acknowledged enough of
+// the previous ones and little motion is left queued.  Detents that arrive
+// faster than the machine can follow are dropped rather than queued, so the
+// machine stops within about one segment after the dial stops.
+
+#pragma once
+
+#include "FluidNCModel.h"
+#include "e4math.h"
+
+// Collection window; also the most motion that is allowed to be queued ahead
+#ifndef JOG_WINDOW_MS
+#    define JOG_WINDOW_MS 60
+#endif
+
+// Longest time one segment can take, which sets the slowest feed rate
+#ifndef JOG_MAX_SEGMENT_MS
+#    define JOG_MAX_SEGMENT_MS 250
+#endif
+
+// Jog segments that may await ok or error.  Only the streamer's own $J=
+// lines count, so other commands do not throttle jogging.
+#ifndef JOG_MAX_IN_FLIGHT
+#    define JOG_MAX_IN_FLIGHT 2
+#endif
+
+// Fastest jog, in mm/min
+#ifndef JOG_MAX_FEED
+#    define JOG_MAX_FEED 5000
+#endif
+
+// Registers the axis speed limits to be picked up by fetch_config("$/axes")
+void detect_jog_limits();
+
+class JogStreamer {
+private:
+    static const int MAX_AXES = 3;
+
+    e4_t _step[MAX_AXES] = { 0 };  // Distance per detent, 0 if the axis is not jogging
+
+    int _pending      = 0;  // Detents not yet sent
+    int _window_start = 0;  // When the first pending detent arrived
+    int _last_send    = 0;
+    int _queued_until = 0;  // Estimated time when the queued motion finishes
+    int _in_flight    = 0;  // Segments awaiting ok or error
+    int _generation   = 0;  // Segments sent before the last reset() are not counted
+
+    e4_t max_feed();
+    void send();
+
+public:
+    void setStep(int axis, e4_t step) {
+        if (axis < MAX_AXES) {
+            _step[axis] = step;
+        }
+    }
+    void add(int detents);
+    void poll();
+    void reset();
+};
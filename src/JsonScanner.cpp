@@ -0,0 +1,252 @@
+// Copyright (c) 2023 - Mitch Bradley
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "JsonScanner.h"
+
+static bool is_bare_char(char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || c == '-' || c == '+' || c == '.' || c == 'E';
+}
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return 0;
+}
+
+void JsonScanner::reset() {
+    _state    = START_DOCUMENT;
+    _depth    = 0;
+    _escape   = 0;
+    _carrying = false;
+    _carry.clear();
+}
+
+// Decoded string bytes go back into the input buffer behind the read
+// pointer, or into the carry buffer if the token began in an earlier call.
+void JsonScanner::put(char*& out, char c) {
+    if (_carrying) {
+        _carry += c;
+    } else {
+        *out++ = c;
+    }
+}
+
+// A \uXXXX escape occupies 6 bytes and its UTF-8 encoding at most 3,
+// so in-place decoding never overtakes the read pointer.
+void JsonScanner::putUnicode(char*& out, uint32_t code) {
+    if (code < 0x80) {
+        put(out, code);
+    } else if (code < 0x800) {
+        put(out, 0xc0 | (code >> 6));
+        put(out, 0x80 | (code & 0x3f));
+    } else {
+        put(out, 0xe0 | (code >> 12));
+        put(out, 0x80 | ((code >> 6) & 0x3f));
+        put(out, 0x80 | (code & 0x3f));
+    }
+}
+
+void JsonScanner::open(char c) {
+    if (_depth == MAX_DEPTH) {
+        // Too deep to track; give up on this document
+        _state = DONE;
+        return;
+    }
+    if (_depth == 0) {
+        _listener->startDocument();
+    }
+    _stack[_depth++] = c;
+    if (c == '{') {
+        _state = EXPECT_KEY;
+        _listener->startObject();
+    } else {
+        _state = EXPECT_VALUE;
+        _listener->startArray();
+    }
+}
+
+void JsonScanner::close(char c) {
+    if (_depth == 0) {
+        return;
+    }
+    --_depth;
+    _state = AFTER_VALUE;
+    if (c == '}') {
+        _listener->endObject();
+    } else {
+        _listener->endArray();
+    }
+    if (_depth == 0) {
+        _state = DONE;
+        _listener->endDocument();
+    }
+}
+
+void JsonScanner::emit(const char* s) {
+    if (_string_is_key) {
+        _state = EXPECT_COLON;
+        _listener->key(s);
+    } else {
+        _state = AFTER_VALUE;
+        _listener->value(s);
+    }
+}
+
+char* JsonScanner::scanString(char* p) {
+    char* start = p;
+    char* out   = p;
+    char  c;
+    while ((c = *p++) != '\0') {
+        if (_escape == 0) {
+            if (c == '"') {
+                if (_carrying) {
+                    _carrying = false;
+                    emit(_carry.c_str());
+                    _carry.clear();
+                } else {
+                    *out = '\0';
+                    emit(start);
+                }
+                return p;
+            }
+            if (c == '\\') {
+                _escape = 1;
+            } else {
+                put(out, c);
+            }
+        } else if (_escape == 1) {
+            _escape = 0;
+            switch (c) {
+                case 'b':
+                    put(out, '\b');
+                    break;
+                case 'f':
+                    put(out, '\f');
+                    break;
+                case 'n':
+                    put(out, '\n');
+                    break;
+                case 'r':
+                    put(out, '\r');
+                    break;
+                case 't':
+                    put(out, '\t');
+                    break;
+                case 'u':
+                    _escape  = 2;
+                    _unicode = 0;
+                    break;
+                default:  // " \ /
+                    put(out, c);
+                    break;
+            }
+        } else {
+            _unicode = (_unicode << 4) | hex_value(c);
+            if (++_escape == 6) {
+                _escape = 0;
+                putUnicode(out, _unicode);
+            }
+        }
+    }
+    // The string continues in the next fragment
+    if (!_carrying) {
+        _carry.assign(start, out - start);
+        _carrying = true;
+    }
+    return p - 1;
+}
+
+char* JsonScanner::scanBare(char* p) {
+    char* start = p;
+    while (is_bare_char(*p)) {
+        ++p;
+    }
+    if (_carrying || *p == '\0') {
+        _carry.append(start, p - start);
+        if (*p == '\0') {
+            // The token continues in the next fragment
+            _carrying = true;
+            return p;
+        }
+        _carrying = false;
+        emit(_carry.c_str());
+        _carry.clear();
+        return p;
+    }
+    // Terminate the token in place, then put back the delimiter
+    char delimiter = *p;
+    *p             = '\0';
+    emit(start);
+    *p = delimiter;
+    return p;
+}
+
+void JsonScanner::parse(char* p) {
+    if (!_listener) {
+        return;
+    }
+    while (*p && _state != DONE) {
+        if (_state == IN_STRING) {
+            p = scanString(p);
+            continue;
+        }
+        if (_state == IN_BARE) {
+            _string_is_key = false;
+            p = scanBare(p);
+            continue;
+        }
+        char c = *p++;
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+            continue;
+        }
+        switch (_state) {
+            case START_DOCUMENT:
+                if (c == '{' || c == '[') {
+                    open(c);
+                }
+                break;
+            case EXPECT_VALUE:
+                if (c == '{' || c == '[') {
+                    open(c);
+                } else if (c == '}' || c == ']') {
+                    close(c);
+                } else if (c == '"') {
+                    _string_is_key = false;
+                    _state         = IN_STRING;
+                } else if (is_bare_char(c)) {
+                    --p;
+                    _state = IN_BARE;
+                }
+                break;
+            case EXPECT_KEY:
+                if (c == '"') {
+                    _string_is_key = true;
+                    _state         = IN_STRING;
+                } else if (c == '}') {
+                    close(c);
+                }
+                break;
+            case EXPECT_COLON:
+                if (c == ':') {
+                    _state = EXPECT_VALUE;
+                }
+                break;
+            case AFTER_VALUE:
+                if (c == ',') {
+                    _state = _stack[_depth - 1] == '{' ? EXPECT_KEY : EXPECT_VALUE;
+                } else if (c == '}' || c == ']') {
+                    close(c);
+                }
+                break;
+            default:
+                break;
+        }
+    }
+}
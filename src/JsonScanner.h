@@ -0,0 +1,64 @@
+// Copyright (c) 2023 - Mitch Bradley
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+// A JSON scanner that works on whole buffers instead of single characters.
+// It drives the same JsonListener interface as JsonStreamingParser and
+// follows its document rules.  startDocument() is issued at the first
+// '{' or '['. endDocument() is issued when the outermost container closes,
+// and everything after that is ignored until reset().
+//
+// A document can span several parse() calls, as FluidNC [JSON:...] messages
+// do.  The text is decoded in place: strings are unescaped and NUL-terminated
+// inside the caller's buffer, so the key and value pointers handed to the
+// listener are only valid for the duration of the callback.  A token that
+// is split between two calls is reassembled in a small carry buffer.
+
+#pragma once
+
+#include <JsonListener.h>
+#include <stdint.h>
+#include <string>
+
+class JsonScanner {
+private:
+    static const int MAX_DEPTH = 20;
+
+    enum scan_state_t {
+        START_DOCUMENT,
+        EXPECT_VALUE,  // or the end of an array
+        EXPECT_KEY,    // or the end of an object
+        EXPECT_COLON,
+        AFTER_VALUE,
+        IN_STRING,
+        IN_BARE,  // number, true, false, null
+        DONE,
+    };
+
+    JsonListener* _listener = nullptr;
+    scan_state_t  _state    = START_DOCUMENT;
+
+    char _stack[MAX_DEPTH];
+    int  _depth = 0;
+
+    bool _string_is_key = false;
+
+    // Escape sequence progress: 0 - none, 1 - after '\', 2..5 - \u hex digits
+    int      _escape  = 0;
+    uint32_t _unicode = 0;
+
+    std::string _carry;
+    bool        _carrying = false;
+
+    void  put(char*& out, char c);
+    void  putUnicode(char*& out, uint32_t code);
+    void  open(char c);
+    void  close(char c);
+    void  emit(const char* s);
+    char* scanString(char* p);
+    char* scanBare(char* p);
+
+public:
+    void setListener(JsonListener* listener) { _listener = listener; }
+    void reset();
+    void parse(char* text);
+};
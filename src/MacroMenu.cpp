@@ -60,13 +60,13 @@ public:
             _selected = 0;
             _items[_selected]->highlight();
         }
-        reDisplay();
+        request_redraw();
     }
 
     void onError(const char* errstr) {
         _error_string = errstr;
         _reading      = false;
-        reDisplay();
+        request_redraw();
     }
 
     void onEntry(void* arg) override {
@@ -154,7 +154,7 @@ public:
             _selected = num_items() - 1;
         }
         _items[_selected]->highlight();
-        reDisplay();
+        request_redraw();
     }
 
     int touchedItem(int x, int y) override { return -1; };
@@ -31,15 +31,11 @@ void ImageButton::show(const Point& where) {
     }
     //drawFilledCircle(where, _radius - 1, BLACK);
 
-    if(_img_cache == NULL)
-    {
-        _img_cache = new LGFX_Sprite(&canvas);
-        _img_cache->setColorDepth(canvas.getColorDepth());
-        _img_cache->createSprite(64,64);
-        drawPngFile(_img_cache, _filename, 0,0);
+    LGFX_Sprite* img = getPngBackground(_filename, 64, 64);
+    if (img) {
+        Point tp = where.to_display();
+        img->pushSprite(tp.x-32, tp.y-32, 0);
     }
-    Point tp = where.to_display();
-    _img_cache->pushSprite(tp.x-32, tp.y-32, 0);
 }
 
 // v2, with alpha blending, at the cost of 3 sprite buffers, one for each state
@@ -131,5 +127,5 @@ void Menu::rotate(int delta) {
     } while (_selected != previous);
 
     _items[_selected]->highlight();
-    reDisplay();
+    request_redraw();
 }
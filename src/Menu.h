@@ -101,7 +101,6 @@ private:
     const char* _filename;
     int         _radius;
     color_t     _outline_color;
-    LGFX_Sprite* _img_cache=NULL;
 //    LGFX_Sprite* _img_cache_highlight=NULL;
 //    LGFX_Sprite* _img_cache_disabled=NULL;
 
@@ -151,7 +151,7 @@ public:
 #endif
         }
         //
-        reDisplay();
+        request_redraw();
     }
 } menuScene;
 
@@ -6,6 +6,7 @@
 #include "Scene.h"
 #include "ConfirmScene.h"
 #include "e4math.h"
+#include "JogStreamer.h"
 
 extern Scene helpScene;
 extern Scene fileSelectScene;
@@ -28,13 +29,14 @@ private:
     bool         _cancelling    = false;
     bool         _cancel_held   = false;
     bool         _continuous    = false;
-    LGFX_Sprite* _bg_image      = nullptr;
-    LGFX_Sprite* _img_home      = nullptr;
-    LGFX_Sprite* _img_homing    = nullptr;
+
+    JogStreamer _mpg;
 
 public:
     MultiFunctionScene() : Scene("MPG", 4, multi_help_text) {}
 
+    bool wantsFastStatus() override { return true; }
+
     e4_t distance(int axis) { return e4_power10(_dist_index[axis] - num_digits()); }
     void unselect_all() { _selected_mask = 0; }
     bool selected(int axis) { return _selected_mask & (1 << axis); }
@@ -58,7 +60,10 @@ public:
 
     void reDisplay() {
         background();
-        drawBackground(_bg_image,0, 45);
+        LGFX_Sprite* bg_image = getBackground("mf_buttons", 240, 256, drawCommandButtons);
+        if (bg_image) {
+            drawBackground(bg_image, 0, 45);
+        }
         drawMenuTitle(current_scene->name());
         drawStatus();
 
@@ -76,27 +81,9 @@ public:
         //text("HOME", 40, 45+64*2+33, state==Homing ? RED : WHITE, TINY, middle_center);
 
 
-        if(state!=Homing)
-        {
-            if(!_img_home)
-            {
-                _img_home = new LGFX_Sprite(&canvas);
-                _img_home->setColorDepth(canvas.getColorDepth());
-                _img_home->createSprite(38,34);
-                drawPngFile(_img_home, "home.png", 0,0);
-            }
-            _img_home->pushSprite(40-19, 45+64*2+33-17, 0);
-        }
-        else
-        {
-            if(!_img_homing)
-            {
-                _img_homing = new LGFX_Sprite(&canvas);
-                _img_homing->setColorDepth(canvas.getColorDepth());
-                _img_homing->createSprite(38,34);
-                drawPngFile(_img_homing, "homing.png", 0,0);
-            }
-            _img_homing->pushSprite(40-19, 45+64*2+33-17, 0);
+        LGFX_Sprite* img_home = getPngBackground(state != Homing ? "home.png" : "homing.png", 38, 34);
+        if (img_home) {
+            img_home->pushSprite(40-19, 45+64*2+33-17, 0);
         }
         if (_cancelling || _cancel_held) {
             centered_text("Jog Canceled", 310, RED, TINY);
@@ -132,14 +119,6 @@ public:
         // if (arg && strcmp((const char*)arg, "Confirmed") == 0) {
         //     zero_axes();
         // }
-        if(!_bg_image)
-        {
-            _bg_image = new LGFX_Sprite(&canvas);
-            _bg_image->setColorDepth(canvas.getColorDepth());
-            _bg_image->createSprite(240,256);
-            drawCommandButtons(_bg_image);
-        }
-
         if (initPrefs()) {
 
             for (size_t axis = 0; axis < 3; axis++) {
@@ -148,7 +127,7 @@ public:
         }
     }
 
-    void drawCommandButtons(LGFX_Sprite* sprite){
+    static void drawCommandButtons(LGFX_Sprite* sprite, const char*){
         int i=0;
         Point where;
 
@@ -164,27 +143,27 @@ public:
                     case 7:
                         //sprite_text(sprite, "Probe", x+40,y+25,WHITE,TINY, middle_center);
                         //sprite_text(sprite, "Left", x+40,y+41,WHITE,TINY, middle_center);
-                        drawPngFile(_bg_image, "probe_left.png", where.x, where.y);
+                        drawPngFile(sprite, "probe_left.png", where.x, where.y);
                         break;
                     case 8:
                         //sprite_text(sprite, "Probe", x+40,y+25,WHITE,TINY, middle_center);
                         //sprite_text(sprite, "Right", x+40,y+41,WHITE,TINY, middle_center);
-                        drawPngFile(_bg_image, "probe_right.png", where.x, where.y);
+                        drawPngFile(sprite, "probe_right.png", where.x, where.y);
                         break;
                     case 9:
                         //sprite_text(sprite, "Probe", x+40,y+25,WHITE,TINY, middle_center);
                         //sprite_text(sprite, "Z", x+40,y+41,WHITE,TINY, middle_center);
-                        drawPngFile(_bg_image, "probe_z.png", where.x, where.y);
+                        drawPngFile(sprite, "probe_z.png", where.x, where.y);
                         break;
                     case 10:
                         //sprite_text(sprite, "Probe", x+40,y+25,WHITE,TINY, middle_center);
                         //sprite_text(sprite, "Rear", x+40,y+41,WHITE,TINY, middle_center);
-                        drawPngFile(_bg_image, "probe_rear.png", where.x, where.y);
+                        drawPngFile(sprite, "probe_rear.png", where.x, where.y);
                         break;
                     case 11:
                         //sprite_text(sprite, "Probe", x+40,y+25,WHITE,TINY, middle_center);
                         //sprite_text(sprite, "Front", x+40,y+41,WHITE,TINY, middle_center);
-                        drawPngFile(_bg_image, "probe_front.png", where.x, where.y);
+                        drawPngFile(sprite, "probe_front.png", where.x, where.y);
                         break;
                 }
                 i++;
@@ -199,6 +178,7 @@ public:
     }
 
     void cancel_jog() {
+        _mpg.reset();
         if (state == Jog) {
             fnc_realtime(JogCancel);
             _continuous = false;
@@ -211,12 +191,12 @@ public:
             _cancel_held = true;
             cancel_jog();
         }
-        reDisplay();
+        request_redraw();
     }
 
     void onTouchRelease() {
         _cancel_held = false;
-        reDisplay();
+        request_redraw();
     }
 
     int getTouchedButton(){
@@ -268,7 +248,7 @@ public:
                 break;
             case 6:
                 if (state == Idle || state == Alarm)
-                    send_line("$H");
+                    send_line("$H", CMD_NO_TIMEOUT);
                 return;
                 break;
             case 7:
@@ -318,31 +298,13 @@ public:
         pop_scene();
     }
 
-        void start_mpg_jog(int delta) {
-
-        // e.g. $J=G91F1000X-10000
-        //std::string cmd(inInches ? "$J=G91F400" : "$J=G91F");
-        // Not sure if inches needs anything different... only testing in mm
-        // I whish there was a jog with acceleration override...
-        std::string cmd("$J=G91F");
+    void start_mpg_jog(int delta) {
         for (int axis = 0; axis < num_axes; ++axis) {
-            if (selected(axis)) {
-                int speed;
-                int range=distance(axis);
-                // This could have more jog speed ranges, but is no longer needed if
-                // fluidNC firmware is running with the jog_acceleration_divisor option
-                // set to 10.0 for example.
-                if (range<=1000)
-                    speed=4000;
-                else
-                    speed=5000;
-                cmd += std::to_string(speed);
-                cmd += axisNumToChar(axis);
-                cmd += e4_to_cstr(delta * distance(axis), inInches ? 3 : 2);
-            }
+            _mpg.setStep(axis, selected(axis) ? distance(axis) : 0);
         }
-        send_line(cmd.c_str());
+        _mpg.add(delta);
     }
+    void onPoll() override { _mpg.poll(); }
 
     void onUILocked() {
         cancel_jog();
@@ -409,13 +371,13 @@ public:
     }
 
     void onDROChange() {
-        reDisplay();
+        request_redraw();
     }
     void onLimitsChange() {
-        reDisplay();
+        request_redraw();
     }
     void onAlarm() {
-        reDisplay();
+        request_redraw();
     }
     void onExit() {
         cancel_jog();
@@ -4,6 +4,8 @@
 #include "Config.h"
 
 #include "Scene.h"
+#include "Widget.h"
+#include "JogStreamer.h"
 #include "ConfirmScene.h"
 #include "e4math.h"
 
@@ -30,11 +32,20 @@ private:
     bool         _cancelling    = false;
     bool         _cancel_held   = false;
     bool         _continuous    = false;
-    LGFX_Sprite* _bg_image      = nullptr;
+
+    JogStreamer _mpg;
+
+    DROWidget _dros[3] = { { 16, 68, 210, 32, 0 }, { 16, 101, 210, 32, 1 }, { 16, 134, 210, 32, 2 } };
+
+    // Set when the last full redraw showed the DROs in the current state
+    bool    _dros_shown  = false;
+    state_t _shown_state = Idle;
 
 public:
     MultiJogScene() : Scene("Jog", 4, jog_help_text) {}
 
+    bool wantsFastStatus() override { return true; }
+
     e4_t distance(int axis) { return e4_power10(_dist_index[axis] - num_digits()); }
     void unselect_all() { _selected_mask = 0; }
     bool selected(int axis) { return _selected_mask & (1 << axis); }
@@ -58,19 +69,24 @@ public:
 
     void reDisplay() {
         background();
-        drawBackground(_bg_image);
+        LGFX_Sprite* bg_image = getPngBackground("jogbg.png");
+        if (bg_image) {
+            drawBackground(bg_image);
+        }
         drawMenuTitle(current_scene->name());
         drawStatus();
 
         if (state != Jog && _cancelling) {
             _cancelling = false;
         }
-        if (_cancelling || _cancel_held) {
+        _dros_shown  = !(_cancelling || _cancel_held);
+        _shown_state = state;
+        if (!_dros_shown) {
             centered_text("Jog Canceled", 120, RED, MEDIUM);
         } else {
-            DRO dro(16, 68, 210, 32);
             for (size_t axis = 0; axis < num_axes; axis++) {
-                dro.draw(axis, _dist_index[axis], selected(axis));
+                _dros[axis].set(_dist_index[axis], selected(axis));
+                _dros[axis].draw();
             }
             if (state == Jog) {
                 if (!_continuous) {
@@ -103,7 +119,6 @@ public:
             zero_axes();
         }
         if (initPrefs()) {
-            _bg_image = createPngBackground("/jogbg.png");
             for (size_t axis = 0; axis < 3; axis++) {
                 getPref("DistanceDigit", axis, &_dist_index[axis]);
             }
@@ -169,6 +184,7 @@ public:
         }
     }
     void cancel_jog() {
+        _mpg.reset();
         if (state == Jog) {
             fnc_realtime(JogCancel);
             _continuous = false;
@@ -211,19 +227,19 @@ public:
     }
     void touch_top() {
         prev_axis();
-        reDisplay();
+        request_redraw();
     }
     void touch_bottom() {
         next_axis();
-        reDisplay();
+        request_redraw();
     }
     void touch_left() {
         increment_distance();
-        reDisplay();
+        request_redraw();
     }
     void touch_right() {
         decrement_distance();
-        reDisplay();
+        request_redraw();
     }
 
     void onTouchPress() {
@@ -231,12 +247,12 @@ public:
             _cancel_held = true;
             cancel_jog();
         }
-        reDisplay();
+        request_redraw();
     }
 
     void onTouchRelease() {
         _cancel_held = false;
-        reDisplay();
+        request_redraw();
     }
 
     void onTouchClick() {
@@ -280,7 +296,7 @@ public:
             } else {
                 select(axis);
             }
-            reDisplay();
+            request_redraw();
             return;
         }
 #if 0
@@ -299,19 +315,12 @@ public:
     }
 
     void start_mpg_jog(int delta) {
-        // e.g. $J=G91F1000X-10000
-        //std::string cmd(inInches ? "$J=G91F400" : "$J=G91F");
-        // Not sure if inches needs anything different... only testing in mm
-        std::string cmd("$J=G91F");
         for (int axis = 0; axis < num_axes; ++axis) {
-            if (selected(axis)) {
-                cmd += std::to_string(max(min(abs(1 * distance(axis)) / 6, 3000),1000));
-                cmd += axisNumToChar(axis);
-                cmd += e4_to_cstr(delta * distance(axis), inInches ? 3 : 2);
-            }
+            _mpg.setStep(axis, selected(axis) ? distance(axis) : 0);
         }
-        send_line(cmd.c_str());
+        _mpg.add(delta);
     }
+    void onPoll() override { _mpg.poll(); }
     void start_button_jog(bool negative) {
         // e.g. $J=G91F1000X-10000
         e4_t total_distance = 0;
@@ -371,14 +380,32 @@ public:
         }
     }
 
+    void paintBackground() override {
+        system_background();
+        LGFX_Sprite* bg_image = getPngBackground("jogbg.png");
+        if (bg_image) {
+            bg_image->pushSprite(0, 0);
+        }
+    }
+
     void onDROChange() {
-        reDisplay();
+        if (!_dros_shown || _cancelling || state != _shown_state) {
+            request_redraw();
+            return;
+        }
+        if (!(machine.changed & (MS_AXES | MS_LIMITS))) {
+            return;
+        }
+        for (int axis = 0; axis < num_axes; axis++) {
+            _dros[axis].update();
+        }
+        refreshDisplay();
     }
     void onLimitsChange() {
-        reDisplay();
+        request_redraw();
     }
     void onAlarm() {
-        reDisplay();
+        request_redraw();
     }
     void onExit() {
         cancel_jog();
@@ -71,7 +71,7 @@ int PieMenu::touchedItem(int x, int y) {
     // If num_items() is even, return the bottom item  (i == num_items()-i)
     // If it is odd, return one of two bottom items stradding -Y axis
 
-    reDisplay();
+    request_redraw();
     return x > 0 ? i : num_items() - i;
 }
 void PieMenu::menuBackground() {
@@ -116,5 +116,5 @@ void PieMenu::onTouchClick() {
 
 void PieMenu::onStateChange(state_t old_state) {
     //
-    reDisplay();
+    request_redraw();
 }
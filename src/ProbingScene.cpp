@@ -7,8 +7,9 @@
 
 class ProbingScene : public Scene {
 private:
-    int  selection   = 0;
-    long oldPosition = 0;
+    int     selection    = 0;
+    long    oldPosition  = 0;
+    state_t _shown_state = Disconnected;
 
     // Saved to NVS
     e4_t _offset  = e4_from_int(0);
@@ -18,7 +19,9 @@ private:
     int  _axis    = 2;  // Z is default
 
 public:
-    ProbingScene() : Scene("Probe") {}
+    ProbingScene() : Scene("Probe") { setEncoderAcceleration(8, 10); }
+
+    bool wantsFastStatus() override { return true; }
 
     void onDialButtonPress() { pop_scene(); }
 
@@ -26,7 +29,7 @@ public:
         // G38.2 G91 F80 Z-20 P8.00
         switch (state) {
             case Idle:
-                send_linef("G38.2G91F%d%c%dP%s", _rate, axisNumToChar(_axis), _travel, e4_to_cstr(_offset, 2));
+                send_linef_timeout(CMD_NO_TIMEOUT, "G38.2G91F%d%c%dP%s", _rate, axisNumToChar(_axis), _travel, e4_to_cstr(_offset, 2));
                 break;
             case Cycle:
                 fnc_realtime(FeedHold);
@@ -44,25 +47,31 @@ public:
     void onRedButtonPress() {
         // G38.2 G91 F80 Z-20 P8.00
         if (state == Cycle || state == Alarm) {
-            fnc_realtime(Reset);            
+            reset_fluidnc();
             return;
         } else if (state == Idle) {
             int retract = _travel < 0 ? _retract : -_retract;
             send_linef("$J=G91F1000%c%d", axisNumToChar(_axis), retract);
             return;
         } else if (state == Hold || state == DoorClosed) {
-            fnc_realtime(Reset);
+            reset_fluidnc();
         }
     }
 
     void onTouchClick() {
         // Rotate through the items to be adjusted.
         rotateNumberLoop(selection, 1, 0, 4);
-        reDisplay();
+        request_redraw();
         ackBeep();
     }
 
-    void onDROChange() { reDisplay(); }
+    void onDROChange() {
+        // Skip reports that change nothing this scene shows
+        if (state == _shown_state && !lastError && !(machine.changed & (MS_AXES | MS_PROBE))) {
+            return;
+        }
+        request_redraw();
+    }
 
     void onEncoder(int delta) {
         if (abs(delta) > 0) {
@@ -93,7 +102,7 @@ public:
                     rotateNumberLoop(_axis, 1, 0, 2);
                     setPref("Axis", _axis);
             }
-            reDisplay();
+            request_redraw();
         }
     }
     void onEntry(void* arg) override {
@@ -108,6 +117,7 @@ public:
     }
 
     void reDisplay() {
+        _shown_state = state;
         background();
         drawMenuTitle(current_scene->name());
         drawStatus();
@@ -131,7 +141,7 @@ public:
             button.draw("Axis", axisNumToCStr(_axis), selection == 4);
 
             //LED led(x - 20, y + height / 2, 10, button.gap());
-            //led.draw(myProbeSwitch);
+            //led.draw(machine.probe);
 
             grnLabel = "Probe";
             redLabel = "Retract";
@@ -147,7 +157,7 @@ public:
                 int y      = 82 - height / 2;
 
                 LED led(120, 190, 10, 5);
-                led.draw(myProbeSwitch);
+                led.draw(machine.probe);
 
                 int width = display_short_side() - x * 2;
                 DRO dro(x, y, width, height);
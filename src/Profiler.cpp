@@ -0,0 +1,110 @@
+// Copyright (c) 2024 - Mitch Bradley
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "Profiler.h"
+
+#ifdef PROFILER
+#    include "System.h"
+#    include "Drawing.h"
+#    include "Text.h"
+
+#    include <algorithm>
+#    include <cstdio>
+
+#    ifndef ARDUINO
+#        include <chrono>
+#    endif
+
+// Slots are written from one thread each; PROF_POLL runs in the protocol
+// task with -DRX_TASK.  A report that races with a write can be off by one
+// sample, which does not matter for these statistics.
+struct profile_ring_t {
+    uint32_t samples[PROFILE_SAMPLES];
+    uint32_t count;  // Total recorded; the ring holds the last PROFILE_SAMPLES
+};
+static profile_ring_t rings[PROF_N_SLOTS];
+
+static const char* slot_names[PROF_N_SLOTS] = { "frame", "bg", "png", "text", "push", "poll", "events", "json" };
+
+static bool overlay = false;
+
+uint32_t profile_micros() {
+#    ifdef ARDUINO
+    return micros();
+#    else
+    using namespace std::chrono;
+    return (uint32_t)duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+#    endif
+}
+
+void profile_record(profile_slot_t slot, uint32_t us) {
+    profile_ring_t& ring                       = rings[slot];
+    ring.samples[ring.count % PROFILE_SAMPLES] = us;
+    ++ring.count;
+}
+
+struct profile_summary_t {
+    uint32_t n;
+    uint32_t p50;
+    uint32_t p99;
+    uint32_t max;
+};
+
+static profile_summary_t summarize(profile_slot_t slot) {
+    const profile_ring_t& ring = rings[slot];
+    uint32_t              n    = std::min<uint32_t>(ring.count, PROFILE_SAMPLES);
+    if (!n) {
+        return { 0, 0, 0, 0 };
+    }
+    uint32_t sorted[PROFILE_SAMPLES];
+    std::copy(ring.samples, ring.samples + n, sorted);
+    std::sort(sorted, sorted + n);
+    return { ring.count, sorted[(n - 1) / 2], sorted[(n - 1) * 99 / 100], sorted[n - 1] };
+}
+
+void profile_report() {
+    dbg_printf("profile (us)    count    p50    p99    max\n");
+    for (int i = 0; i < PROF_N_SLOTS; i++) {
+        profile_summary_t s = summarize((profile_slot_t)i);
+        if (s.n) {
+            dbg_printf("%-10s %10u %6u %6u %6u\n", slot_names[i], (unsigned)s.n, (unsigned)s.p50, (unsigned)s.p99, (unsigned)s.max);
+        }
+    }
+#ifdef ARDUINO
+    size_t   rx_peak, rx_size;
+    uint32_t rx_overflows, rx_lost;
+    fnc_rx_stats(rx_peak, rx_size, rx_overflows, rx_lost);
+    dbg_printf("FNC RX peak %u of %u bytes, %u overflows, about %u bytes lost\n", (unsigned)rx_peak, (unsigned)rx_size, (unsigned)rx_overflows, (unsigned)rx_lost);
+#endif
+}
+
+void profile_toggle_overlay() {
+    overlay = !overlay;
+    profile_report();
+}
+
+bool profile_overlay_enabled() {
+    return overlay;
+}
+
+// Only the slots that explain a slow frame fit on the round display
+static const profile_slot_t overlay_slots[] = { PROF_FRAME, PROF_TEXT, PROF_PUSH, PROF_POLL };
+
+void profile_draw_overlay() {
+    const int line_height = 14;
+    const int n_lines     = sizeof(overlay_slots) / sizeof(overlay_slots[0]);
+    const int width       = 150;
+    int       x           = (canvas.width() - width) / 2;
+    int       y           = canvas.height() - 40 - n_lines * line_height;
+
+    canvas.fillRect(x, y, width, n_lines * line_height, BLACK);
+    markDirty(x, y, width, n_lines * line_height);
+    for (auto slot : overlay_slots) {
+        profile_summary_t s = summarize(slot);
+        char              line[40];
+        snprintf(line, sizeof(line), "%s %u / %u us", slot_names[slot], (unsigned)s.p50, (unsigned)s.p99);
+        text(line, canvas.width() / 2, y + line_height / 2, YELLOW, TINY, middle_center);
+        y += line_height;
+    }
+}
+#endif
@@ -0,0 +1,58 @@
+// Copyright (c) 2024 - Mitch Bradley
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+// Optional timing of the render path and the event loop.  Build with
+// -DPROFILER to enable it.  Otherwise PROFILE_SCOPE() expands to nothing
+// and none of the profiler is compiled.
+//
+// PROFILE_SCOPE(slot) times the rest of the enclosing block.  Each slot
+// keeps its most recent PROFILE_SAMPLES durations, from which
+// profile_report() prints p50, p99 and max on the debug port.  The same
+// summary can be drawn over every frame; AboutScene toggles it with a
+// long touch.
+
+#pragma once
+
+#include "Config.h"
+
+enum profile_slot_t {
+    PROF_FRAME,       // Scene::reDisplay() from the frame scheduler
+    PROF_BACKGROUND,  // Scene::background()
+    PROF_PNG,         // PNG decoding
+    PROF_TEXT,        // text()
+    PROF_PUSH,        // refreshDisplay()
+    PROF_POLL,        // protocol_poll(), including fnc_poll()
+    PROF_EVENTS,      // dispatch_events()
+    PROF_JSON,        // handle_json()
+    PROF_N_SLOTS,
+};
+
+#ifdef PROFILER
+#    include <cstdint>
+
+#    ifndef PROFILE_SAMPLES
+#        define PROFILE_SAMPLES 64
+#    endif
+
+uint32_t profile_micros();
+void     profile_record(profile_slot_t slot, uint32_t us);
+void     profile_report();
+void     profile_toggle_overlay();
+bool     profile_overlay_enabled();
+void     profile_draw_overlay();  // Called by refreshDisplay() before pushing
+
+class ProfileScope {
+    profile_slot_t _slot;
+    uint32_t       _start;
+
+public:
+    explicit ProfileScope(profile_slot_t slot) : _slot(slot), _start(profile_micros()) {}
+    ~ProfileScope() { profile_record(_slot, profile_micros() - _start); }
+};
+
+#    define PROFILE_CONCAT2(a, b) a##b
+#    define PROFILE_CONCAT(a, b) PROFILE_CONCAT2(a, b)
+#    define PROFILE_SCOPE(slot) ProfileScope PROFILE_CONCAT(_profile_scope_, __LINE__)(slot)
+#else
+#    define PROFILE_SCOPE(slot)
+#endif
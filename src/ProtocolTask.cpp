@@ -0,0 +1,114 @@
+// Copyright (c) 2024 - Mitch Bradley
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "ProtocolTask.h"
+#include "FluidNCModel.h"
+#include "System.h"
+#include "Profiler.h"
+
+#include <string>
+
+#ifdef RX_TASK
+#    ifdef ARDUINO
+#        include <freertos/FreeRTOS.h>
+#        include <freertos/task.h>
+#    else
+#        include <chrono>
+#        include <thread>
+#    endif
+
+struct outgoing_t {
+    std::string    line;
+    int            timeout;
+    command_done_t done;
+    bool           reset;  // Drop the commands queued before this one
+};
+
+static SpscQueue<outgoing_t, 16>            outgoing;
+static SpscQueue<std::function<void()>, 64> ui_events;
+
+// The queues are sized so these waits are rare; they only occur when one
+// side has fallen far behind the other.
+void protocol_send_line(const char* line, int timeout, const command_done_t& done) {
+    outgoing_t item { line, timeout, done, false };
+    while (!outgoing.push(item)) {
+        delay_ms(1);
+    }
+}
+
+// Queued behind the lines already sent, so the lines sent after it survive
+void protocol_reset_commands() {
+    outgoing_t item { "", 0, nullptr, true };
+    while (!outgoing.push(item)) {
+        delay_ms(1);
+    }
+}
+
+void run_on_ui(const std::function<void()>& fn) {
+    while (!ui_events.push(fn)) {
+        delay_ms(1);
+    }
+}
+
+void run_ui_events() {
+    std::function<void()> fn;
+    while (ui_events.pop(fn)) {
+        fn();
+    }
+}
+
+void protocol_poll() {
+    PROFILE_SCOPE(PROF_POLL);
+    outgoing_t item;
+    while (outgoing.pop(item)) {
+        if (item.reset) {
+            commands.clear();
+        } else {
+            commands.add(item.line.c_str(), item.timeout, item.done);
+        }
+    }
+    commands.poll();
+    fnc_poll();
+}
+
+#    ifdef ARDUINO
+// loop() runs on core 1, so the protocol gets core 0 to itself
+static void protocol_task(void* arg) {
+    for (;;) {
+        protocol_poll();
+        vTaskDelay(1);
+    }
+}
+
+void start_protocol_task() {
+    xTaskCreatePinnedToCore(protocol_task, "protocol", 8192, nullptr, 2, nullptr, 0);
+}
+#    else
+void start_protocol_task() {
+    std::thread([] {
+        for (;;) {
+            protocol_poll();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }).detach();
+}
+#    endif
+
+#else
+void start_protocol_task() {}
+
+void protocol_poll() {
+    PROFILE_SCOPE(PROF_POLL);
+    commands.poll();
+    fnc_poll();
+}
+
+void protocol_send_line(const char* line, int timeout, const command_done_t& done) {
+    commands.add(line, timeout, done);
+    commands.poll();
+}
+
+void protocol_reset_commands() {
+    commands.clear();
+}
+#endif
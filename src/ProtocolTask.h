@@ -0,0 +1,102 @@
+// Copyright (c) 2024 - Mitch Bradley
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+// With -DRX_TASK, the FluidNC protocol - fnc_poll() and the GrblParserC
+// callbacks - runs in its own task, on the other core on ESP32 or in a
+// std::thread on the host, so a slow redraw cannot stall UART reception.
+// The UI never touches the parser directly:
+//  - Lines to send are handed to the protocol task's CommandQueue.
+//  - Status report fields are handed over through a TripleBuffer.
+//  - Callbacks that affect scenes are queued with run_on_ui() and run by
+//    dispatch_events().
+// Without RX_TASK, all of these reduce to direct calls in loop().
+
+#pragma once
+
+#include "InputQueue.h"    // SpscQueue
+#include "CommandQueue.h"  // command_done_t
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+// Hands the most recent value from one writer to one reader without locks.
+// The writer fills back() and calls publish(); the reader calls update()
+// and, if it returns true, reads front().  A value published while the
+// reader is busy replaces the previous one rather than queuing behind it.
+template <typename T>
+class TripleBuffer {
+    static const uint8_t FRESH = 4;
+
+    T                    _buffers[3];
+    std::atomic<uint8_t> _middle { 1 };
+    uint8_t              _write = 0;  // Owned by the writer
+    uint8_t              _read  = 2;  // Owned by the reader
+
+public:
+    T& back() { return _buffers[_write]; }
+    void publish() { _write = _middle.exchange(_write | FRESH, std::memory_order_acq_rel) & 3; }
+
+    bool update() {
+        if (!(_middle.load(std::memory_order_acquire) & FRESH)) {
+            return false;
+        }
+        _read = _middle.exchange(_read, std::memory_order_acq_rel) & 3;
+        return true;
+    }
+    const T& front() const { return _buffers[_read]; }
+};
+
+void start_protocol_task();
+
+// Receives from FluidNC and sends queued commands.  Called from loop(), or
+// from the protocol task when there is one.
+void protocol_poll();
+
+// Queues a line for FluidNC; done, if given, runs in the UI loop when it
+// is answered
+void protocol_send_line(const char* line, int timeout, const command_done_t& done);
+
+// Drops queued and unanswered commands, as when FluidNC goes away
+void protocol_reset_commands();
+
+// run_on_ui_copy() is run_on_ui() for handlers of strings that the parser
+// reuses, such as the line being parsed.  The strings are copied only when
+// the handler has to wait for the UI loop.
+#ifdef RX_TASK
+// Runs fn in the UI loop; called from the protocol task
+void run_on_ui(const std::function<void()>& fn);
+
+// Runs the functions queued by run_on_ui(); called from dispatch_events()
+void run_ui_events();
+
+template <typename F>
+void run_on_ui_copy(const char* s, F fn) {
+    std::string copy(s);
+    run_on_ui([copy, fn]() mutable { fn(&copy[0]); });
+}
+template <typename F>
+void run_on_ui_copy(const char* s1, const char* s2, F fn) {
+    std::string copy1(s1);
+    std::string copy2(s2);
+    run_on_ui([copy1, copy2, fn]() mutable { fn(&copy1[0], &copy2[0]); });
+}
+#else
+// Without a protocol task these are direct calls, with no copies and no
+// std::function on the path of every status report
+template <typename F>
+inline void run_on_ui(F fn) {
+    fn();
+}
+inline void run_ui_events() {}
+
+template <typename F>
+inline void run_on_ui_copy(const char* s, F fn) {
+    fn(const_cast<char*>(s));
+}
+template <typename F>
+inline void run_on_ui_copy(char* s1, char* s2, F fn) {
+    fn(s1, s2);
+}
+#endif
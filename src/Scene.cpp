@@ -3,6 +3,9 @@
 
 #include "Scene.h"
 #include "System.h"
+#include "InputQueue.h"
+#include "ProtocolTask.h"
+#include "Profiler.h"
 
 #ifndef ARDUINO
 #    include <sys/stat.h>
@@ -22,13 +25,53 @@ int touchDeltaY;
 
 std::vector<Scene*> scene_stack;
 
+static bool     redraw_pending  = false;
+static uint32_t last_frame_ms   = 0;
+static uint32_t frames_drawn    = 0;
+static uint32_t redraws_merged  = 0;  // Requests folded into one already pending
+static uint32_t frames_deferred = 0;  // Loop passes where a pending redraw waited for the frame time
+
+void request_redraw() {
+    if (redraw_pending) {
+        ++redraws_merged;
+    }
+    redraw_pending = true;
+}
+
+bool redraw_requested() {
+    return redraw_pending;
+}
+
+static void render_frame() {
+    if (!redraw_pending) {
+        return;
+    }
+    uint32_t now = milliseconds();
+    if (frames_drawn && now - last_frame_ms < UPDATE_RATE_MS) {
+        ++frames_deferred;
+        return;
+    }
+    redraw_pending = false;
+    last_frame_ms  = now;
+    ++frames_drawn;
+    PROFILE_SCOPE(PROF_FRAME);
+    current_scene->reDisplay();
+}
+
+void redraw_stats(uint32_t& frames, uint32_t& coalesced, uint32_t& deferred) {
+    frames    = frames_drawn;
+    coalesced = redraws_merged;
+    deferred  = frames_deferred;
+}
+
 void activate_scene(Scene* scene, void* arg) {
     if (current_scene) {
         current_scene->onExit();
     }
     current_scene = scene;
+    note_activity();
     current_scene->onEntry(arg);
-    current_scene->reDisplay();
+    request_redraw();
 }
 void push_scene(Scene* scene, void* arg) {
     scene_stack.push_back(current_scene);
@@ -59,6 +102,7 @@ bool touchIsCenter() {
 }
 
 void dispatch_button(bool pressed, int button) {
+    note_activity();
     switch (button) {
         case 0:
             if (pressed) {
@@ -98,6 +142,7 @@ void dispatch_touch() {
     auto t = touch.getDetail();
     if (t.state != last_touch_state) {
         last_touch_state = t.state;
+        note_activity();
         touchX           = t.x - sprite_offset.x;
         touchY           = t.y - sprite_offset.y;
         int delta;
@@ -159,20 +204,131 @@ void schedule_action(ActionHandler _action) {
     action = _action;
 }
 
+// A pause longer than this restarts the encoder velocity estimate
+#define ENCODER_IDLE_MS 150
+
+// Estimates the encoder speed in counts per second from the time between
+// successive count changes, smoothed so a single fast loop does not spike it.
+static int encoder_rate(int delta, int ms) {
+    static int last_ms = 0;
+    static int rate    = 0;
+
+    int dt  = ms - last_ms;
+    last_ms = ms;
+
+    if (dt > ENCODER_IDLE_MS) {
+        rate = 0;
+        return rate;
+    }
+    if (dt < 1) {
+        dt = 1;
+    }
+    rate = (rate + abs(delta) * 1000 / dt) / 2;
+    return rate;
+}
+
+// Switch edges closer together than this are contact bounce
+#define BUTTON_DEBOUNCE_MS 5
+
+struct switch_state_t {
+    bool     reported;  // Last state passed to dispatch_button()
+    bool     pending;   // An edge is waiting for the bounce to settle
+    bool     level;
+    uint32_t ms;
+};
+static switch_state_t switches[3] = {};
+
+static void report_switch(int button, bool locked) {
+    switch_state_t& sw = switches[button];
+    sw.pending         = false;
+    if (sw.level != sw.reported) {
+        sw.reported = sw.level;
+        if (!locked) {
+            input_dispatched(sw.ms);
+            dispatch_button(sw.level, button);
+        }
+    }
+}
+
+// An edge from the switch interrupts is reported once the next edge is at
+// least BUTTON_DEBOUNCE_MS later, or once that long has passed with no other
+// edge, so a quick tap during a slow redraw yields both press and release.
+static void dispatch_switches(bool locked) {
+    input_event_t event;
+    while (button_events.pop(event)) {
+        if (event.button >= 3) {
+            continue;
+        }
+        switch_state_t& sw = switches[event.button];
+        if (sw.pending && event.ms - sw.ms >= BUTTON_DEBOUNCE_MS) {
+            report_switch(event.button, locked);
+        }
+        sw.pending = true;
+        sw.level   = event.value;
+        sw.ms      = event.ms;
+    }
+    // If the queue overflowed, the last edges are missing; catch up with
+    // the latest level from the interrupt handler
+    for (int i = 0; i < 3; i++) {
+        bool level = button_levels[i];
+        if (level != switches[i].level) {
+            switches[i].pending = true;
+            switches[i].level   = level;
+            switches[i].ms      = button_level_ms[i];
+        }
+    }
+    uint32_t now = milliseconds();
+    for (int i = 0; i < 3; i++) {
+        if (switches[i].pending && now - switches[i].ms >= BUTTON_DEBOUNCE_MS) {
+            report_switch(i, locked);
+        }
+    }
+}
+
 void dispatch_events() {
+    PROFILE_SCOPE(PROF_EVENTS);
     update_events();
+    run_ui_events();  // FluidNC callbacks deferred by the protocol task
 
     static int16_t oldEncoder   = 0;
-    int16_t        newEncoder   = get_encoder();
-    int16_t        encoderDelta = newEncoder - oldEncoder;
-    if (encoderDelta) {
-        oldEncoder = newEncoder;
+    int            encoderDelta = 0;
+    int            rate         = 0;
+    uint32_t       first_ms     = 0;
 
-        int16_t scaledDelta = current_scene->scale_encoder(encoderDelta);
+    input_event_t event;
+    while (encoder_events.pop(event)) {
+        int16_t delta = event.value - oldEncoder;
+        if (delta) {
+            oldEncoder = event.value;
+            if (!encoderDelta) {
+                first_ms = event.ms;
+            }
+            encoderDelta += delta;
+            rate = encoder_rate(delta, event.ms);
+        }
+    }
+    // Counts that have not yet raised an interrupt, and all counts on
+    // platforms without encoder interrupts
+    int16_t newEncoder = get_encoder();
+    int16_t delta      = newEncoder - oldEncoder;
+    if (delta) {
+        oldEncoder = newEncoder;
+        if (!encoderDelta) {
+            first_ms = milliseconds();
+        }
+        encoderDelta += delta;
+        rate = encoder_rate(delta, milliseconds());
+    }
+    if (encoderDelta) {
+        int16_t scaledDelta = current_scene->scale_encoder(encoderDelta, rate);
         if (scaledDelta && !ui_locked()) {
+            note_activity();
+            input_dispatched(first_ms);
             current_scene->onEncoder(scaledDelta);
         }
     }
+    dispatch_switches(ui_locked());
+
     static bool last_locked_change = false;
 
     if (!ui_locked()) {
@@ -209,6 +365,9 @@ void dispatch_events() {
         action();
         action = nullptr;
     }
+    current_scene->onPoll();
+    input_pass_done();
+    render_frame();
 }
 
 static const char* setting_name(const char* base_name, int axis) {
@@ -260,7 +419,16 @@ bool Scene::initPrefs() {
     return _prefs;
 }
 
-int Scene::scale_encoder(int delta) {
+int Scene::scale_encoder(int delta, int rate) {
+    if (_accel_rate) {
+        int gain = rate / _encoder_scale / _accel_rate;
+        if (gain > _accel_max) {
+            gain = _accel_max;
+        }
+        if (gain > 1) {
+            delta *= gain;
+        }
+    }
     _encoder_accum += delta;
     int res = _encoder_accum / _encoder_scale;
     _encoder_accum %= _encoder_scale;
@@ -268,7 +436,9 @@ int Scene::scale_encoder(int delta) {
 }
 
 void Scene::background() {
+    PROFILE_SCOPE(PROF_BACKGROUND);
     system_background();
+    markAllDirty();
 }
 
 void act_on_state_change() {
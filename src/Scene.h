@@ -24,9 +24,19 @@ private:
     int _encoder_accum = 0;
     int _encoder_scale = 1;
 
+    // Encoder acceleration: above _accel_rate detents/s, each detent counts
+    // as rate/_accel_rate detents, up to _accel_max.  0 disables it.
+    int _accel_rate = 0;
+    int _accel_max  = 1;
+
 protected:
     const char** _help_text = nullptr;
 
+    void setEncoderAcceleration(int rate, int max_gain) {
+        _accel_rate = rate;
+        _accel_max  = max_gain;
+    }
+
 public:
     Scene(const char* name, int encoder_scale = 1, const char** help_text = nullptr) :
         _name(name), _help_text(help_text), _encoder_scale(encoder_scale) {}
@@ -58,6 +68,11 @@ public:
     virtual void onLimitsChange() {}
     virtual void onMessage(char* command, char* arguments) {}
     virtual void onEncoder(int delta) {}
+    virtual void onPoll() {}  // Called on every pass through the event loop
+
+    // True for scenes that show live position or status, which want
+    // frequent status reports while the machine is moving
+    virtual bool wantsFastStatus() { return false; }
     virtual void reDisplay() {}
     virtual void onEntry(void* arg = nullptr) {}
     virtual void onExit() {}
@@ -67,7 +82,7 @@ public:
 
     bool initPrefs();
 
-    int scale_encoder(int delta);
+    int scale_encoder(int delta, int rate);
 
     void setPref(const char* name, int value);
     void getPref(const char* name, int* value);
@@ -77,6 +92,10 @@ public:
     void getPref(const char* name, int axis, char* value, int maxlen);
 
     void background();
+
+    // Repaints the scene's static backdrop without marking the canvas dirty.
+    // Widgets call it under a clip rectangle to erase themselves.
+    virtual void paintBackground() { system_background(); }
 };
 
 bool touchIsCenter();
@@ -113,5 +132,13 @@ void schedule_action(ActionHandler action);
 
 extern Scene* current_scene;
 
+// request_redraw() marks the current scene for repainting.  dispatch_events()
+// repaints it at most once every UPDATE_RATE_MS, so a burst of messages or
+// encoder counts costs one redraw.  Call reDisplay() directly only when the
+// display must be painted before returning.
+void request_redraw();
+bool redraw_requested();  // A full redraw is waiting for the next frame
+void redraw_stats(uint32_t& frames, uint32_t& coalesced, uint32_t& deferred);
+
 void dispatch_events();
 void act_on_state_change();
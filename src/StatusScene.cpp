@@ -2,6 +2,7 @@
 // Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
 
 #include "Scene.h"
+#include "Widget.h"
 
 extern Scene menuScene;
 
@@ -18,8 +19,38 @@ private:
 
     ovrd_display_t overd_display = FRO;
 
+    DROWidget      _dros[3] = { { 16, 68, 210, 32, 0 }, { 16, 101, 210, 32, 1 }, { 16, 134, 210, 32, 2 } };
+    ProgressWidget _progress { 20, 170, 192, 10 };
+    TextWidget     _legend { 0, 181, 240, 24, TINY };
+
+    // What the last full redraw was based on; anything else is updated in place
+    const char* _shown_state_string = nullptr;
+    int         _shown_alarm        = -1;
+
+    void setLegend() {
+        if (state == Cycle || state == Hold) {
+            // Feed override
+            char legend[50];
+            switch (overd_display) {
+                case FRO:
+                    sprintf(legend, "Feed Rate Ovr:%d%%", machine.fro);
+                    break;
+                case SRO:
+                    sprintf(legend, "Spindle Ovr:%d%%", machine.sro);
+                    break;
+                case RT_FEED_SPEED:
+                    sprintf(legend, "Fd:%d Spd:%d", machine.feed, machine.speed);
+            }
+            _legend.set(legend);
+        } else {
+            _legend.set(mode_string(), GREEN);
+        }
+    }
+
 public:
-    StatusScene() : Scene("Status") {}
+    StatusScene() : Scene("Status") { setEncoderAcceleration(8, 10); }
+
+    bool wantsFastStatus() override { return true; }
 
     void onExit() override {}
 
@@ -52,7 +83,7 @@ public:
                 case RT_FEED_SPEED:
                     overd_display = FRO;
             }
-            reDisplay();
+            request_redraw();
         }
         fnc_realtime(StatusReport);  // sometimes you want an extra status
     }
@@ -63,7 +94,7 @@ public:
                 if (alarm_is_critical()) {
                     // Critical alarm that must be hard-cleared with a CTRL-X reset
                     // since streaming execution of GCode is blocked
-                    fnc_realtime(Reset);
+                    reset_fluidnc();
                 } else {
                     // Non-critical alarm that can be soft-cleared
                     send_line("$X");
@@ -73,7 +104,7 @@ public:
             case Homing:
             case Hold:
             case DoorClosed:
-                fnc_realtime(Reset);
+                reset_fluidnc();
                 break;
         }
     }
@@ -94,78 +125,93 @@ public:
                 break;
             case Alarm:
                 if (alarm_is_homing()) {
-                    send_line("$H");
+                    send_line("$H", CMD_NO_TIMEOUT);
                 }
                 break;
         }
         fnc_realtime(StatusReport);
     }
 
+    // Moves an override toward current + delta, within 10..200%, using
+    // coarse 10% steps where possible to keep the command count down
+    void adjust_override(int current, int delta, realtime_cmd_t coarse_plus, realtime_cmd_t coarse_minus, realtime_cmd_t fine_plus,
+                         realtime_cmd_t fine_minus) {
+        int target = current + delta;
+        if (target > 200) {
+            target = 200;
+        }
+        if (target < 10) {
+            target = 10;
+        }
+        int change = target - current;
+        for (; change >= 10; change -= 10) {
+            fnc_realtime(coarse_plus);
+        }
+        for (; change <= -10; change += 10) {
+            fnc_realtime(coarse_minus);
+        }
+        for (; change > 0; --change) {
+            fnc_realtime(fine_plus);
+        }
+        for (; change < 0; ++change) {
+            fnc_realtime(fine_minus);
+        }
+    }
+
     void onEncoder(int delta) {
         if (state == Cycle) {
             switch (overd_display) {
                 case FRO:
-                    if (delta > 0 && myFro < 200) {
-                        fnc_realtime(FeedOvrFinePlus);
-                    } else if (delta < 0 && myFro > 10) {
-                        fnc_realtime(FeedOvrFineMinus);
-                    }
+                    adjust_override(machine.fro, delta, FeedOvrCoarsePlus, FeedOvrCoarseMinus, FeedOvrFinePlus, FeedOvrFineMinus);
                     break;
                 case SRO:
-                    if (delta > 0 && mySro < 200) {
-                        fnc_realtime(SpindleOvrFinePlus);
-                    } else if (delta < 0 && mySro > 10) {
-                        fnc_realtime(SpindleOvrFineMinus);
-                    }
+                    adjust_override(machine.sro, delta, SpindleOvrCoarsePlus, SpindleOvrCoarseMinus, SpindleOvrFinePlus, SpindleOvrFineMinus);
                     break;
                 case RT_FEED_SPEED:
                     overd_display = FRO;
             }
 
-            reDisplay();
+            request_redraw();
         }
     }
 
-    void onDROChange() { reDisplay(); }
-    void onLimitsChange() { reDisplay(); }
+    void onDROChange() {
+        // The status line and button legends only change with the state
+        if (my_state_string != _shown_state_string || lastAlarm != _shown_alarm) {
+            request_redraw();
+            return;
+        }
+        if (!(machine.changed & (MS_AXES | MS_LIMITS | MS_PERCENT | MS_OVERRIDES | MS_FEED_SPEED))) {
+            return;
+        }
+        for (auto& dro : _dros) {
+            dro.update();
+        }
+        if (state == Cycle || state == Hold) {
+            _progress.update();
+        }
+        setLegend();
+        _legend.update();
+        refreshDisplay();
+    }
+    void onLimitsChange() { request_redraw(); }
 
     void reDisplay() {
         background();
         drawMenuTitle(current_scene->name());
         drawStatus();
+        _shown_state_string = my_state_string;
+        _shown_alarm        = lastAlarm;
 
-        DRO dro(16, 68, 210, 32);
-        dro.draw(0, -1, true);
-        dro.draw(1, -1, true);
-        dro.draw(2, -1, true);
+        for (auto& dro : _dros) {
+            dro.draw();
+        }
 
-        int y = 170;
         if (state == Cycle || state == Hold) {
-            int width  = 192;
-            int height = 10;
-            if (myPercent > 0) {
-                drawRect(20, y, width, height, 5, LIGHTGREY);
-                width = (width * myPercent) / 100;
-                if (width > 0) {
-                    drawRect(20, y, width, height, 5, GREEN);
-                }
-            }
-            // Feed override
-            char legend[50];
-            switch (overd_display) {
-                case FRO:
-                    sprintf(legend, "Feed Rate Ovr:%d%%", myFro);
-                    break;
-                case SRO:
-                    sprintf(legend, "Spindle Ovr:%d%%", mySro);
-                    break;
-                case RT_FEED_SPEED:
-                    sprintf(legend, "Fd:%d Spd:%d", myFeed, mySpeed);
-            }
-            centered_text(legend, y + 23);
-        } else {
-            centered_text(mode_string(), y + 23, GREEN, TINY);
+            _progress.draw();
         }
+        setLegend();
+        _legend.draw();
 
         const char* encoder_button_text = "Menu";
 
@@ -0,0 +1,43 @@
+// Copyright (c) 2024 - Mitch Bradley
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+// FNV-1a string hash usable both at compile time and at run time, so that
+// keys from the protocol can be dispatched with a switch statement:
+//
+//   switch (str_hash(key)) {
+//       case str_hash("path"): ...
+//
+// A hash match does not prove a string match, so case bodies compare the
+// string before acting on it (see str_is()).
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+constexpr uint32_t fnv_offset = 2166136261u;
+constexpr uint32_t fnv_prime  = 16777619u;
+
+// Single-return recursion keeps this a valid C++11 constexpr function.
+// The recursion is a tail call, so run-time use compiles to a loop.
+constexpr uint32_t fnv1a(const char* s, uint32_t hash) {
+    return *s ? fnv1a(s + 1, (hash ^ (uint8_t)*s) * fnv_prime) : hash;
+}
+
+constexpr uint32_t str_hash(const char* s) {
+    return fnv1a(s, fnv_offset);
+}
+
+// Hash of the first len characters of s, for names that are not null-terminated
+inline uint32_t str_hash_n(const char* s, size_t len) {
+    uint32_t hash = fnv_offset;
+    while (len--) {
+        hash = (hash ^ (uint8_t)*s++) * fnv_prime;
+    }
+    return hash;
+}
+
+inline bool str_is(const char* s, const char* expected) {
+    return strcmp(s, expected) == 0;
+}
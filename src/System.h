@@ -6,12 +6,15 @@
 #include "Config.h"
 #include "Encoder.h"
 
+constexpr static const int UPDATE_RATE_MS = 30;  // minimum time between display frames in milliseconds
+
 #ifdef ARDUINO
 #    include <Arduino.h>
 #    include <LittleFS.h>
-constexpr static const int UPDATE_RATE_MS = 30;  // minimum refresh rate in milliseconds
-extern Stream&             debugPort;
-void                       init_fnc_uart(int uart_num, int tx_pin, int rx_pin);
+extern Stream& debugPort;
+void           init_fnc_uart(int uart_num, int tx_pin, int rx_pin);
+// Peak bytes waiting in the UART driver, its capacity, and receive overruns
+void fnc_rx_stats(size_t& high_water, size_t& buffer_size, uint32_t& overflows, uint32_t& lost_bytes);
 #endif  // ARDUINO
 
 #ifdef USE_LOVYANGFX
@@ -5,6 +5,7 @@
 
 #include "System.h"
 #include "FluidNCModel.h"
+#include "Drawing.h"  // initShadow()
 #include "NVS.h"
 
 #include <Esp.h>  // ESP.restart()
@@ -31,24 +32,80 @@ void ledcolor(int n) {
     digitalWrite(16, !(n & 2));
     digitalWrite(17, !(n & 4));
 }
+// Received bytes are pulled from the UART driver in bulk, as many as
+// are available in one call, and then handed to GrblParser one at a
+// time from this local buffer.  That avoids a driver call, with its
+// ring-buffer locking, for every byte.
+static uint8_t rx_buf[256];
+static size_t  rx_len = 0;
+static size_t  rx_pos = 0;
+
+// The driver reports receive overruns through its event queue.  The
+// exact number of bytes lost is unknown, but an overrun discards at
+// most the contents of the hardware FIFO.
+static QueueHandle_t uart_events = NULL;
+static size_t        rx_buffer_size;
+static size_t        rx_high_water = 0;
+static uint32_t      rx_overflows  = 0;
+static uint32_t      rx_lost_bytes = 0;
+
+static void check_uart_events() {
+    uart_event_t event;
+    while (uart_events && xQueueReceive(uart_events, &event, 0) == pdTRUE) {
+        if (event.type == UART_FIFO_OVF || event.type == UART_BUFFER_FULL) {
+            ++rx_overflows;
+            rx_lost_bytes += UART_FIFO_LEN;
+            dbg_printf("FNC RX overflow, about %u bytes lost so far\n", rx_lost_bytes);
+        }
+    }
+}
+
+static bool fill_rx_buf() {
+    check_uart_events();
+    size_t avail = 0;
+    uart_get_buffered_data_len(fnc_uart_port, &avail);
+    if (avail == 0) {
+        return false;
+    }
+    if (avail > rx_high_water) {
+        rx_high_water = avail;
+    }
+    if (avail > sizeof(rx_buf)) {
+        avail = sizeof(rx_buf);
+    }
+    int res = uart_read_bytes(fnc_uart_port, rx_buf, avail, 0);
+    if (res <= 0) {
+        return false;
+    }
+    rx_len = res;
+    rx_pos = 0;
+    return true;
+}
+
+void fnc_rx_stats(size_t& high_water, size_t& buffer_size, uint32_t& overflows, uint32_t& lost_bytes) {
+    high_water  = rx_high_water;
+    buffer_size = rx_buffer_size;
+    overflows   = rx_overflows;
+    lost_bytes  = rx_lost_bytes;
+}
+
 extern "C" int fnc_getchar() {
-    char c;
-    int  res = uart_read_bytes(fnc_uart_port, &c, 1, 0);
-    if (res == 1) {
+    if (rx_pos == rx_len && !fill_rx_buf()) {
+        return -1;
+    }
+    char c = rx_buf[rx_pos++];
 #ifdef LED_DEBUG
-        if (c == '\r' || c == '\n') {
-            ledcolor(0);
-        } else {
-            ledcolor(c & 7);
-        }
+    if (c == '\r' || c == '\n') {
+        ledcolor(0);
+    } else {
+        ledcolor(c & 7);
+    }
 #endif
-        update_rx_time();
+    update_rx_time();
 #ifdef ECHO_FNC_TO_DEBUG
-        dbg_write(c);
+    dbg_write(c);
 #endif
-        return c;
-    }
-    return -1;
+    return c;
 }
 
 extern "C" void poll_extra() {
@@ -88,6 +145,8 @@ void init_fnc_uart(int uart_num, int tx_pin, int rx_pin) {
     fnc_uart_port = (uart_port_t)uart_num;
     int baudrate  = FNC_BAUD;
     uart_driver_delete(fnc_uart_port);
+    uart_events = NULL;
+    rx_len = rx_pos = 0;
     uart_set_pin(fnc_uart_port, (gpio_num_t)tx_pin, (gpio_num_t)rx_pin, -1, -1);
     uart_config_t conf;
 #if defined(CONFIG_IDF_TARGET_ESP32) || defined(CONFIG_IDF_TARGET_ESP32S2)
@@ -113,7 +172,8 @@ void init_fnc_uart(int uart_num, int tx_pin, int rx_pin) {
     // see https://docs.espressif.com/projects/esp-idf/en/stable/esp32/api-reference/peripherals/uart.html
     // Removed only for no flow control option, to keep current behavior...
     #ifndef DISABLE_FLOW_CONTROL
-        uart_driver_install(fnc_uart_port, 256, 0, 0, NULL, ESP_INTR_FLAG_IRAM);
+        rx_buffer_size = 256;
+        uart_driver_install(fnc_uart_port, rx_buffer_size, 0, 8, &uart_events, ESP_INTR_FLAG_IRAM);
         uart_set_sw_flow_ctrl(fnc_uart_port, true, 64, 120);
     #else
         // With flow control (and previously), the receive buffer was 256 bytes. Without flow control, it is better to have more
@@ -122,7 +182,8 @@ void init_fnc_uart(int uart_num, int tx_pin, int rx_pin) {
         // 8192 bytes takes roughly 73ms to fill at 1 Mbaud, which means in general we should try to process the receive buffer
         // at least at this rate or faster, but mostly (and only) true if the receive data is larger than 8KB.
         // The only large one chunk of data that seems possible is preferences.json, which seems around 5.5KB in my case.
-        uart_driver_install(fnc_uart_port, 8192, 0, 0, NULL, 0);
+        rx_buffer_size = 8192;
+        uart_driver_install(fnc_uart_port, rx_buffer_size, 0, 8, &uart_events, 0);
     #endif
     uint32_t baud;
     uart_get_baudrate(fnc_uart_port, &baud);
@@ -143,6 +204,7 @@ void init_system() {
     #else
         canvas.createSprite(240, 240);  // display.width(), display.height());
     #endif
+    initShadow();
 }
 void resetFlowControl() {
 #ifndef DISABLE_FLOW_CONTROL
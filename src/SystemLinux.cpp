@@ -0,0 +1,509 @@
+// Copyright (c) 2023 Mitch Bradley
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+// System interface routines for headless Linux
+//
+// This port runs setup() and loop() against an in-process FluidNC
+// stand-in instead of a serial port, so the whole UI loop - parsing,
+// scene logic and rendering - can be profiled deterministically on a
+// build machine without pendant hardware.  The display is the SDL
+// panel from M5GFX, using SDL's dummy video driver unless the
+// SDL_VIDEODRIVER environment variable says otherwise.
+//
+// Usage: FluidDial [scriptfile [repeat]]
+//
+// The script is a text file whose lines are fed to the pendant as if
+// FluidNC had sent them, one line per fnc_poll().  Lines beginning
+// with # are comments.  Lines beginning with @ are directives:
+//   @encoder N   - turn the simulated encoder by N counts
+//   @idle N      - deliver nothing for N loop iterations
+// The simulated FluidNC acknowledges every line that the pendant
+// sends with "ok" and answers status report requests with the most
+// recent <...> report seen in the script.
+
+// stdio.h must precede the include of M5Unified.h in System.h
+// in order for image files to work correctly
+#include "stdio.h"
+
+#include "System.h"
+#include "FluidNCModel.h"
+#include "M5GFX.h"
+#include "Drawing.h"
+#include "InputQueue.h"
+#include "Scene.h"  // redraw_stats()
+#include "Profiler.h"
+#include "NVS.h"
+
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <time.h>
+#include <atomic>
+#include <fstream>
+#include <string>
+#include <vector>
+
+LGFX_Device& display = M5.Display;
+LGFX_Sprite  canvas(&M5.Display);
+
+m5::Speaker_Class& speaker     = M5.Speaker;
+m5::Touch_Class&   touch       = M5.Touch;
+m5::Button_Class&  dialButton  = M5.BtnB;
+m5::Button_Class&  greenButton = M5.BtnC;
+m5::Button_Class&  redButton   = M5.BtnA;
+
+bool round_display = true;
+
+// Allocation counters, so a benchmark run can report heap churn.  Both
+// threads allocate in the linux_rx_task build.
+static std::atomic<size_t> n_allocs { 0 };
+static std::atomic<size_t> n_alloc_bytes { 0 };
+
+void* operator new(size_t size) {
+    ++n_allocs;
+    n_alloc_bytes += size;
+    void* p = malloc(size ? size : 1);
+    if (!p) {
+        abort();
+    }
+    return p;
+}
+void operator delete(void* p) noexcept {
+    free(p);
+}
+void operator delete(void* p, size_t size) noexcept {
+    free(p);
+}
+
+static uint64_t micros64() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+void system_background() {
+    LGFX_Sprite* bg = getPngBackground("PCBackground.png", canvas.width(), canvas.height());
+    if (bg) {
+        bg->pushSprite(0, 0);
+    } else {
+        drawPngFile("PCBackground.png", 0, 0);
+    }
+}
+
+void update_events() {
+    lgfx::Panel_sdl::loop();
+    M5.update();
+}
+
+extern "C" int milliseconds() {
+    return (int)(micros64() / 1000);
+}
+
+void delay_ms(uint32_t ms) {
+    SDL_Delay(ms);
+}
+
+void drawPngFile(const char* filename, int x, int y) {
+    drawPngFile(&canvas, filename, x, y);
+}
+void drawPngFile(LGFX_Sprite* sprite, const char* filename, int x, int y) {
+    std::string fn("data/");
+    fn += filename;
+    // When datum is middle_center, the origin is the center of the canvas and the
+    // +Y direction is down.
+    sprite->drawPngFile(fn.c_str(), x, -y, 0, 0, 0, 0, 1.0f, 1.0f, datum_t::middle_center);
+}
+
+// Used when no script file is given
+static const char* default_script[] = {
+    "Grbl 3.7 [FluidNC v3.7.0 (linux-sim) '$' for help]",
+    "<Idle|MPos:0.000,0.000,0.000|FS:0,0|WCO:0.000,0.000,0.000>",
+    "[GC:G0 G54 G17 G21 G90 G94 M5 M9 T0 F0 S0]",
+    "<Jog|MPos:1.000,0.000,0.000|FS:1000,0>",
+    "<Jog|MPos:2.000,0.500,0.000|FS:1000,0>",
+    "<Jog|MPos:3.000,1.000,0.000|FS:1000,0>",
+    "<Idle|MPos:3.000,1.000,0.000|FS:0,0>",
+    "<Run|MPos:3.000,1.000,-0.100|FS:500,12000|Ov:100,100,100|SD:12.50,/sd/part.nc>",
+    "<Run|MPos:4.250,1.750,-0.100|FS:500,12000|SD:25.00,/sd/part.nc>",
+    "<Run|MPos:5.500,2.500,-0.100|FS:500,12000|SD:50.00,/sd/part.nc>",
+    "<Run|MPos:6.750,3.250,-0.100|FS:500,12000|SD:75.00,/sd/part.nc>",
+    "<Idle|MPos:6.750,3.250,5.000|FS:0,0>",
+    nullptr,
+};
+
+// In-process stand-in for FluidNC
+class FluidNCSim {
+private:
+    std::vector<std::string> _script;
+
+    size_t _line   = 0;  // Index of the script line being delivered
+    size_t _pos    = 0;  // Position within that line
+    int    _repeat = 1;
+    int    _idle   = 0;  // Loop iterations to skip before the next line
+
+    bool _line_done = false;  // Gates delivery to one line per fnc_poll()
+
+    std::string _pending;  // Responses queued by the simulated FluidNC
+    std::string _rx_line;  // Line being received from the pendant
+    std::string _status = "<Idle|MPos:0.000,0.000,0.000|FS:0,0>";
+
+    void respond(const std::string& s) {
+        _pending += s;
+        _pending += '\n';
+    }
+
+    void directive(const std::string& line) {
+        int n = atoi(line.c_str() + line.find(' ') + 1);
+        if (line.compare(0, 8, "@encoder") == 0) {
+            encoder += n;
+        } else if (line.compare(0, 5, "@idle") == 0) {
+            _idle = n;
+        }
+    }
+
+    void next_line() {
+        _pos = 0;
+        if (++_line == _script.size() && --_repeat > 0) {
+            _line = 0;
+        }
+    }
+
+public:
+    int16_t encoder = 0;
+
+    size_t bytes_fed      = 0;
+    size_t lines_fed      = 0;
+    size_t lines_acked    = 0;
+    size_t status_replies = 0;
+
+    bool load(const char* filename, int repeat) {
+        _repeat = repeat;
+        if (!filename) {
+            for (const char** s = default_script; *s; ++s) {
+                _script.push_back(*s);
+            }
+            return true;
+        }
+        std::ifstream in(filename);
+        if (!in) {
+            return false;
+        }
+        std::string line;
+        while (std::getline(in, line)) {
+            if (line.length() && line.back() == '\r') {
+                line.pop_back();
+            }
+            if (line.length() && line[0] != '#') {
+                _script.push_back(line);
+            }
+        }
+        return true;
+    }
+
+    bool finished() { return _line >= _script.size() && _pending.empty(); }
+
+    void loop_tick() {
+        _line_done = false;
+        if (_idle) {
+            --_idle;
+            _line_done = true;
+        }
+    }
+
+    // Bytes from the pendant to FluidNC
+    void receive(uint8_t c) {
+        switch (c) {
+            case '?':  // StatusReport
+                ++status_replies;
+                respond(_status);
+                return;
+            case '\r':
+                return;
+            case '\n':
+                if (_rx_line.length()) {
+                    if (_rx_line == "$G") {
+                        respond("[GC:G0 G54 G17 G21 G90 G94 M5 M9 T0 F0 S0]");
+                    }
+                    respond("ok");
+                    ++lines_acked;
+                    _rx_line.clear();
+                }
+                return;
+        }
+        if (c < 0x20 || c >= 0x80) {
+            return;  // Other realtime characters
+        }
+        _rx_line += (char)c;
+    }
+
+    // Bytes from FluidNC to the pendant
+    int deliver() {
+        if (_pending.length()) {
+            int c = (uint8_t)_pending[0];
+            _pending.erase(0, 1);
+            ++bytes_fed;
+            return c;
+        }
+        while (!_line_done && _line < _script.size()) {
+            const std::string& line = _script[_line];
+            if (line[0] == '@') {
+                directive(line);
+                next_line();
+                if (_idle) {
+                    _line_done = true;
+                }
+                continue;
+            }
+            if (_pos < line.length()) {
+                ++bytes_fed;
+                return (uint8_t)line[_pos++];
+            }
+            if (line[0] == '<') {
+                _status = line;
+            }
+            ++lines_fed;
+            next_line();
+            _line_done = true;
+            ++bytes_fed;
+            return '\n';
+        }
+        return -1;
+    }
+} sim;
+
+#ifdef RX_TASK
+#    include <mutex>
+// The protocol thread and the UI loop both reach the simulator
+static std::mutex sim_mutex;
+#    define SIM_LOCK std::lock_guard<std::mutex> sim_lock(sim_mutex)
+#else
+#    define SIM_LOCK
+#endif
+
+void init_system() {
+    // Headless unless the user asks for a real video driver
+    if (!getenv("SDL_VIDEODRIVER")) {
+        setenv("SDL_VIDEODRIVER", "dummy", 1);
+    }
+    lgfx::Panel_sdl::setup();
+
+    auto cfg = M5.config();
+    M5.begin(cfg);
+
+    // Make an offscreen canvas that can be copied to the screen all at once
+    canvas.createSprite(display.width(), display.height());
+    initShadow();
+
+    display.clear();
+    speaker.setVolume(0);
+}
+
+Point sprite_offset { 0, 0 };
+
+void show_logo() {}
+void base_display() {
+    display.clear();
+}
+
+void next_layout(int delta) {}
+
+void resetFlowControl() {}
+
+extern "C" void fnc_putchar(uint8_t c) {
+    SIM_LOCK;
+    sim.receive(c);
+}
+
+extern "C" int fnc_getchar() {
+    int c;
+    {
+        SIM_LOCK;
+        c = sim.deliver();
+    }
+    if (c >= 0) {
+        update_rx_time();
+#ifdef ECHO_FNC_TO_DEBUG
+        dbg_write(c);
+#endif
+    }
+    return c;
+}
+
+extern "C" void poll_extra() {}
+
+void dbg_write(uint8_t c) {
+    putchar(c);
+}
+
+void dbg_print(const char* s) {
+    fputs(s, stdout);
+}
+
+bool screen_encoder(int x, int y, int& delta) {
+    return false;
+}
+
+bool screen_button_touched(bool pressed, int x, int y, int& button) {
+    return false;
+}
+
+bool switch_button_touched(bool& pressed, int& button) {
+    return false;
+}
+
+void ackBeep() {}
+
+void deep_sleep(int us) {}
+
+int16_t get_encoder() {
+    SIM_LOCK;
+    return sim.encoder;
+}
+
+static FILE* prefFile(const char* handle, const char* pname, const char* mode) {
+    static char fname[60];
+    snprintf(fname, 60, "%s/%s", handle, pname);
+
+    return fopen(fname, mode);
+}
+
+void nvs_get_str(nvs_handle_t handle, const char* name, char* value, size_t* len) {
+    FILE* fd = prefFile(handle, name, "rb");
+    if (fd) {
+        *len = fread(value, 1, *len - 1, fd);
+        fclose(fd);
+    } else {
+        *len = 0;
+    }
+    value[*len] = '\0';
+}
+void nvs_set_str(nvs_handle_t handle, const char* name, const char* value) {
+    FILE* fd = prefFile(handle, name, "wb");
+    if (fd) {
+        fwrite(value, 1, strlen(value), fd);
+        fclose(fd);
+    }
+}
+
+void nvs_get_i32(nvs_handle_t handle, const char* name, int32_t* value) {
+    char   strval[20];
+    size_t len = 20;
+    nvs_get_str(handle, name, strval, &len);
+    if (*strval) {
+        *value = atoi(strval);
+    }
+}
+void nvs_set_i32(nvs_handle_t handle, const char* name, int32_t value) {
+    char valstr[20];
+    snprintf(valstr, 20, "%d", value);
+    nvs_set_str(handle, name, valstr);
+}
+
+nvs_handle_t nvs_init(const char* name) {
+    char dname[50];
+    mkdir("prefs", 0755);
+    snprintf(dname, 50, "prefs/%s", name);
+    mkdir(dname, 0755);
+
+    return strdup(dname);
+}
+
+bool ui_locked() {
+    return false;
+}
+
+extern void setup();
+extern void loop();
+
+int main(int argc, char** argv) {
+    if (argc > 3) {
+        printf("Usage: %s [scriptfile [repeat]]\n", argv[0]);
+        exit(1);
+    }
+    const char* script = argc > 1 ? argv[1] : nullptr;
+    int         repeat = argc > 2 ? atoi(argv[2]) : 1;
+    if (!sim.load(script, repeat < 1 ? 1 : repeat)) {
+        printf("Can't open %s\n", script);
+        exit(1);
+    }
+
+    setup();
+
+    size_t   setup_allocs = n_allocs;
+    size_t   setup_bytes  = n_alloc_bytes;
+    size_t   loops        = 0;
+    uint64_t max_us       = 0;
+    uint64_t min_us       = UINT64_MAX;
+    uint64_t start_us     = micros64();
+
+    for (;;) {
+        {
+            SIM_LOCK;
+            if (sim.finished()) {
+                break;
+            }
+            sim.loop_tick();
+        }
+        uint64_t t0 = micros64();
+        loop();
+        uint64_t dt = micros64() - t0;
+        if (dt > max_us) {
+            max_us = dt;
+        }
+        if (dt < min_us) {
+            min_us = dt;
+        }
+        ++loops;
+    }
+
+    uint64_t elapsed_us = micros64() - start_us;
+    if (!loops) {
+        min_us = 0;
+    }
+    if (!elapsed_us) {
+        elapsed_us = 1;
+    }
+
+    printf("\nloops: %zu in %llu ms, %.1f loops/s\n", loops, (unsigned long long)(elapsed_us / 1000), loops * 1e6 / elapsed_us);
+    printf("loop time us: min %llu avg %llu max %llu\n",
+           (unsigned long long)min_us,
+           (unsigned long long)(loops ? elapsed_us / loops : 0),
+           (unsigned long long)max_us);
+    printf("allocations: %zu (%zu bytes) during loop, %zu (%zu bytes) during setup\n",
+           n_allocs - setup_allocs,
+           n_alloc_bytes - setup_bytes,
+           setup_allocs,
+           setup_bytes);
+    printf("fnc link: %zu bytes, %zu lines fed, %zu lines acked, %zu status replies\n",
+           sim.bytes_fed,
+           sim.lines_fed,
+           sim.lines_acked,
+           sim.status_replies);
+    int bg_hits, bg_misses, bg_evictions;
+    backgroundCacheStats(bg_hits, bg_misses, bg_evictions);
+    printf("background cache: %d hits, %d misses, %d evictions\n", bg_hits, bg_misses, bg_evictions);
+    uint32_t max_latency, avg_latency, latency_samples, input_dropped;
+    input_stats(max_latency, avg_latency, latency_samples, input_dropped);
+    printf("input latency: max %u ms, avg %u ms over %u commands, %u events dropped\n",
+           (unsigned)max_latency,
+           (unsigned)avg_latency,
+           (unsigned)latency_samples,
+           (unsigned)input_dropped);
+    uint32_t cmd_done, cmd_errors, cmd_timeouts, cmd_max, cmd_avg;
+    commands.stats(cmd_done, cmd_errors, cmd_timeouts, cmd_max, cmd_avg);
+    printf("commands: %u answered (%u errors), %u timed out, latency max %u ms avg %u ms\n",
+           (unsigned)cmd_done,
+           (unsigned)cmd_errors,
+           (unsigned)cmd_timeouts,
+           (unsigned)cmd_max,
+           (unsigned)cmd_avg);
+    uint32_t frames, coalesced, deferred;
+    redraw_stats(frames, coalesced, deferred);
+    printf("redraws: %u frames, %u requests coalesced, %u loop passes waiting for the frame time\n",
+           (unsigned)frames,
+           (unsigned)coalesced,
+           (unsigned)deferred);
+#ifdef PROFILER
+    profile_report();
+#endif
+    return 0;
+}
@@ -29,7 +29,12 @@ m5::Button_Class&  redButton   = M5.BtnA;
 bool round_display = true;
 
 void system_background() {
-    drawPngFile("PCBackground.png", 0, 0);
+    LGFX_Sprite* bg = getPngBackground("PCBackground.png", canvas.width(), canvas.height());
+    if (bg) {
+        bg->pushSprite(0, 0);
+    } else {
+        drawPngFile("PCBackground.png", 0, 0);
+    }
 }
 
 void update_events() {
@@ -270,6 +275,7 @@ void init_system() {
 
     // Make an offscreen canvas that can be copied to the screen all at once
     canvas.createSprite(display.width(), display.height());
+    initShadow();
 
     // Draw the logo screen
     display.clear();
@@ -2,7 +2,10 @@
 // Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
 
 #include "Text.h"
-#include <map>
+#include "Drawing.h"  // markDirty()
+#include "Profiler.h"
+#include <algorithm>
+#include <vector>
 
 const GFXfont* font[] = {
     // lgfx::v1::IFont* font[] = {
@@ -13,18 +16,221 @@ const GFXfont* font[] = {
     &fonts::FreeMonoBold18pt7b,  // MEDIUM_MONO
 };
 
+// Glyph atlas.  Numbers are redrawn on every status report, and drawString()
+// rasterizes each GFXfont glyph bit by bit.  The characters that make up
+// numbers are instead rendered once per font into small 1-bit sprites, and
+// later drawn by pushing those sprites with the ink color set in their
+// palettes, so one atlas serves every color.  Each glyph is padded because
+// ink can extend past the advance width.  The least recently used atlases
+// are dropped beyond GLYPH_CACHE_BYTES.
+#ifndef GLYPH_CACHE_BYTES
+#    define GLYPH_CACHE_BYTES 8000
+#endif
+
+static const char atlas_chars[] = "0123456789-.";
+static const int  n_atlas_chars = sizeof(atlas_chars) - 1;
+static const int  glyph_pad     = 2;
+
+struct glyph_atlas_t {
+    fontnum_t    fontnum;
+    int          anchor_y;  // Vertical position of a middle datum in each glyph sprite
+    int          advance[n_atlas_chars];
+    LGFX_Sprite* glyphs[n_atlas_chars];
+    size_t       bytes;
+    uint32_t     last_used;
+};
+static std::vector<glyph_atlas_t*> atlases;
+static size_t                      atlas_bytes = 0;
+static uint32_t                    atlas_clock = 0;
+
+static int atlas_index(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c == '-') {
+        return 10;
+    }
+    if (c == '.') {
+        return 11;
+    }
+    return -1;
+}
+
+static void free_atlas(glyph_atlas_t* atlas) {
+    for (auto& glyph : atlas->glyphs) {
+        if (glyph) {
+            glyph->deleteSprite();
+            delete glyph;
+        }
+    }
+    delete atlas;
+}
+
+static bool evict_atlas() {
+    if (atlases.empty()) {
+        return false;
+    }
+    auto lru = atlases.begin();
+    for (auto it = atlases.begin(); it != atlases.end(); ++it) {
+        if ((*it)->last_used < (*lru)->last_used) {
+            lru = it;
+        }
+    }
+    atlas_bytes -= (*lru)->bytes;
+    free_atlas(*lru);
+    atlases.erase(lru);
+    return true;
+}
+
+static glyph_atlas_t* build_atlas(fontnum_t fontnum) {
+    auto atlas     = new glyph_atlas_t();
+    atlas->fontnum = fontnum;
+
+    canvas.setFont(font[fontnum]);
+    int height      = canvas.fontHeight() + glyph_pad * 2;
+    atlas->anchor_y = glyph_pad + canvas.fontHeight() / 2;
+
+    char str[2] = { '\0', '\0' };
+    for (int i = 0; i < n_atlas_chars; i++) {
+        str[0]            = atlas_chars[i];
+        atlas->advance[i] = canvas.textWidth(str);
+        int width         = atlas->advance[i] + glyph_pad * 2;
+
+        auto glyph = new LGFX_Sprite(&canvas);
+        glyph->setColorDepth(1);
+        atlas->glyphs[i] = glyph;
+        if (!glyph->createSprite(width, height)) {
+            free_atlas(atlas);
+            return nullptr;
+        }
+        glyph->createPalette();
+        atlas->bytes += (size_t)(width + 7) / 8 * height;
+
+        // Palette index 0 is transparent and 1 is the ink
+        glyph->fillSprite(0);
+        glyph->setFont(font[fontnum]);
+        glyph->setTextDatum(middle_left);
+        glyph->setTextColor(1);
+        glyph->drawString(str, glyph_pad, atlas->anchor_y);
+    }
+    return atlas;
+}
+
+static glyph_atlas_t* get_atlas(fontnum_t fontnum) {
+    for (auto atlas : atlases) {
+        if (atlas->fontnum == fontnum) {
+            atlas->last_used = ++atlas_clock;
+            return atlas;
+        }
+    }
+    glyph_atlas_t* atlas;
+    while (!(atlas = build_atlas(fontnum))) {
+        if (!evict_atlas()) {
+            return nullptr;
+        }
+    }
+    if (atlas->bytes > GLYPH_CACHE_BYTES) {
+        // Too big to keep; such fonts are drawn directly
+        free_atlas(atlas);
+        return nullptr;
+    }
+    while (atlas_bytes + atlas->bytes > GLYPH_CACHE_BYTES && evict_atlas()) {}
+    atlas->last_used = ++atlas_clock;
+    atlases.push_back(atlas);
+    atlas_bytes += atlas->bytes;
+    return atlas;
+}
+
+// Draws msg from the glyph atlas if it can, returning false if msg has
+// characters outside the atlas or datum is not vertically centered
+static bool atlas_text(LGFX_Sprite* sprite, const char* msg, int x, int y, int color, fontnum_t fontnum, int datum) {
+    if ((datum & ~(top_center | top_right)) != middle_left) {
+        return false;
+    }
+    for (const char* p = msg; *p; ++p) {
+        if (atlas_index(*p) < 0) {
+            return false;
+        }
+    }
+    glyph_atlas_t* atlas = get_atlas(fontnum);
+    if (!atlas) {
+        return false;
+    }
+
+    int width = 0;
+    for (const char* p = msg; *p; ++p) {
+        width += atlas->advance[atlas_index(*p)];
+    }
+    if (datum & top_right) {
+        x -= width;
+    } else if (datum & top_center) {
+        x -= width / 2;
+    }
+    for (const char* p = msg; *p; ++p) {
+        int i = atlas_index(*p);
+        atlas->glyphs[i]->setPaletteColor(1, (uint16_t)color);
+        atlas->glyphs[i]->pushSprite(sprite, x - glyph_pad, y - atlas->anchor_y, 0);
+        x += atlas->advance[i];
+    }
+    return true;
+}
+
 void sprite_text(LGFX_Sprite* sprite, const char* msg, int x, int y, int color, fontnum_t fontnum, int datum) {
+    if (atlas_text(sprite, msg, x, y, color, fontnum, datum)) {
+        return;
+    }
     sprite->setFont(font[fontnum]);
     sprite->setTextDatum(datum);
     sprite->setTextColor(color);
     sprite->drawString(msg, x, y);
 }
 
+// Records the canvas area covered by a string drawn with the current font.
+// The box is padded because glyphs can extend past their advance widths.
+static void markText(const char* msg, int x, int y, fontnum_t fontnum, int datum) {
+    const int pad = 4;
+    int       w   = canvas.textWidth(msg);
+    int       h   = canvas.fontHeight();
+    if (datum & top_center) {
+        x -= w / 2;
+    } else if (datum & top_right) {
+        x -= w;
+    }
+    if (datum & middle_left) {
+        y -= h / 2;
+    } else if (datum & bottom_left) {
+        y -= h;
+    } else if (datum & baseline_left) {
+        // Measure the ink above and below the baseline so descenders are covered
+        const GFXfont* f       = font[fontnum];
+        int            ascent  = 0;
+        int            descent = 0;
+        for (const char* p = msg; *p; ++p) {
+            uint8_t code = (uint8_t)*p;
+            if (code < f->first || code > f->last) {
+                continue;
+            }
+            const GFXglyph& g = f->glyph[code - f->first];
+            ascent            = std::max<int>(ascent, -g.yOffset);
+            descent           = std::max<int>(descent, g.yOffset + g.height);
+        }
+        y -= ascent;
+        h = ascent + descent;
+    }
+    markDirty(x - pad, y - pad, w + pad * 2, h + pad * 2);
+}
+
 void text(const char* msg, int x, int y, int color, fontnum_t fontnum, int datum) {
+    PROFILE_SCOPE(PROF_TEXT);
     canvas.setFont(font[fontnum]);
-    canvas.setTextDatum(datum);
-    canvas.setTextColor(color);
-    canvas.drawString(msg, x, y);
+    if (!atlas_text(&canvas, msg, x, y, color, fontnum, datum)) {
+        canvas.setTextDatum(datum);
+        canvas.setTextColor(color);
+        canvas.drawString(msg, x, y);
+    }
+    if (!allDirty()) {
+        markText(msg, x, y, fontnum, datum);
+    }
 }
 void text(const std::string& msg, int x, int y, int color, fontnum_t fontnum, int datum) {
     text(msg.c_str(), x, y, color, fontnum, datum);
@@ -43,44 +249,149 @@ void centered_text(const char* msg, int y, int color, fontnum_t fontnum) {
     text(msg, canvas.width() / 2, y, color, fontnum);
 }
 
-void auto_text(const std::string& txt, int x, int y, int w, int color, fontnum_t fontnum, int datum, bool tryfonts, bool trimleft) {
-    bool doesnotfit = true;
-    while (true) {  // forever loop
-        int f = fontnum;
-        if (canvas.textWidth(txt.c_str(), font[fontnum]) <= w) {
-            doesnotfit = false;
-            break;
-        }
-        if (fontnum && tryfonts) {
-            fontnum = (fontnum_t)(--f);
+// Text measurement for auto_text().  Widths come straight from the GFXfont
+// glyph tables, using the same rule as LovyanGFX textWidth(), so one pass
+// of prefix sums measures every possible truncation of a string.
+struct glyph_metrics_t {
+    int advance;
+    int extent;  // Ink width of the glyph when it ends a string
+    int lead;    // Ink to the left of the origin when it starts a string
+};
+
+static glyph_metrics_t glyph_metrics(const GFXfont* f, char c) {
+    uint8_t code = (uint8_t)c;
+    if (code < f->first || code > f->last) {
+        return { 0, 0, 0 };  // Not drawn
+    }
+    const GFXglyph& g = f->glyph[code - f->first];
+    return { g.xAdvance, std::max<int>(g.xAdvance, g.width + g.xOffset), std::max<int>(0, -g.xOffset) };
+}
+
+// sums[i] is the total advance of the first i characters of s
+static void advance_sums(const GFXfont* f, const std::string& s, std::vector<int>& sums) {
+    sums.resize(s.length() + 1);
+    sums[0] = 0;
+    for (size_t i = 0; i < s.length(); i++) {
+        sums[i + 1] = sums[i] + glyph_metrics(f, s[i]).advance;
+    }
+}
+
+// Width of the substring s[begin, end)
+static int range_width(const GFXfont* f, const std::string& s, const std::vector<int>& sums, size_t begin, size_t end) {
+    if (begin == end) {
+        return 0;
+    }
+    return glyph_metrics(f, s[begin]).lead + sums[end - 1] - sums[begin] + glyph_metrics(f, s[end - 1]).extent;
+}
+
+static int string_width(const GFXfont* f, const std::string& s) {
+    std::vector<int> sums;
+    advance_sums(f, s, sums);
+    return range_width(f, s, sums, 0, s.length());
+}
+
+// Shortens s with an ellipsis until it fits in w, keeping at least 4 characters.
+// The width is monotonic in the number of characters kept, so binary search
+// finds the longest fit.
+static std::string truncate_text(const GFXfont* f, const std::string& s, int w, bool trimleft) {
+    std::vector<int> sums;
+    advance_sums(f, s, sums);
+    int    dotswidth = string_width(f, " ...");
+    size_t n         = s.length();
+
+    auto fits = [&](size_t keep) {
+        size_t begin = trimleft ? n - keep : 0;
+        return range_width(f, s, sums, begin, begin + keep) + dotswidth <= w;
+    };
+
+    if (n <= 4) {
+        return s;
+    }
+    if (!fits(4)) {
+        return trimleft ? s.substr(n - 4) : s.substr(0, 4);
+    }
+    size_t lo = 4, hi = n - 1;  // fits(lo) is true
+    while (lo < hi) {
+        size_t mid = (lo + hi + 1) / 2;
+        if (fits(mid)) {
+            lo = mid;
         } else {
-            break;
+            hi = mid - 1;
         }
     }
+    return trimleft ? "... " + s.substr(n - lo) : s.substr(0, lo) + " ...";
+}
 
-    std::string s(txt);
+// Recently fitted strings.  The file list redraws the same names on every
+// encoder detent, so the results are kept and reused.
+#ifndef FIT_CACHE_SIZE
+#    define FIT_CACHE_SIZE 8
+#endif
 
-    if (doesnotfit) {
-        int dotswidth = canvas.textWidth(" ...");
+struct fitted_text_t {
+    std::string txt;
+    int         w;
+    fontnum_t   requested;
+    bool        tryfonts;
+    bool        trimleft;
+    std::string fitted;
+    fontnum_t   fontnum;
+    uint32_t    last_used;
+};
+static fitted_text_t fit_cache[FIT_CACHE_SIZE];
+static uint32_t      fit_clock = 0;
 
-        while (s.length() > 4) {
-            if (trimleft) {
-                s.erase(0, 1);
-            } else {
-                s.erase(s.length() - 1);
-            }
-            if (canvas.textWidth(s.c_str()) + dotswidth <= w) {
-                if (trimleft) {
-                    s.insert(0, "... ");
-                } else {
-                    s += " ...";
-                }
-                break;
-            }
+static const fitted_text_t& fit_text(const std::string& txt, int w, fontnum_t fontnum, bool tryfonts, bool trimleft) {
+    fitted_text_t* lru = &fit_cache[0];
+    for (auto& entry : fit_cache) {
+        if (entry.last_used && entry.w == w && entry.requested == fontnum && entry.tryfonts == tryfonts && entry.trimleft == trimleft &&
+            entry.txt == txt) {
+            entry.last_used = ++fit_clock;
+            return entry;
+        }
+        if (entry.last_used < lru->last_used) {
+            lru = &entry;
+        }
+    }
+
+    fitted_text_t& entry = *lru;
+    entry.txt            = txt;
+    entry.w              = w;
+    entry.requested      = fontnum;
+    entry.tryfonts       = tryfonts;
+    entry.trimleft       = trimleft;
+    entry.last_used      = ++fit_clock;
+
+    // Try smaller fonts before truncating
+    while (string_width(font[fontnum], txt) > w) {
+        if (!(fontnum && tryfonts)) {
+            entry.fontnum = fontnum;
+            entry.fitted  = truncate_text(font[fontnum], txt, w, trimleft);
+            return entry;
         }
+        fontnum = (fontnum_t)(fontnum - 1);
     }
+    entry.fontnum = fontnum;
+    entry.fitted  = txt;
+    return entry;
+}
 
-    text(s, x, y, color, fontnum, datum);
+void auto_text(const std::string& txt, int x, int y, int w, int color, fontnum_t fontnum, int datum, bool tryfonts, bool trimleft) {
+    const fitted_text_t& fit = fit_text(txt, w, fontnum, tryfonts, trimleft);
+    text(fit.fitted, x, y, color, fit.fontnum, datum);
+}
+void auto_text(LGFX_Sprite* sprite,
+               const std::string& txt,
+               int                x,
+               int                y,
+               int                w,
+               int                color,
+               fontnum_t          fontnum,
+               int                datum,
+               bool               tryfonts,
+               bool               trimleft) {
+    const fitted_text_t& fit = fit_text(txt, w, fontnum, tryfonts, trimleft);
+    sprite_text(sprite, fit.fitted.c_str(), x, y, color, fit.fontnum, datum);
 }
 void auto_text(const std::string& txt, Point xy, int w, int color, fontnum_t fontnum, int datum, bool tryfonts, bool trimleft) {
     Point dispxy = xy.to_display();
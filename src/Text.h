@@ -35,6 +35,18 @@ void auto_text(const std::string& txt,
                bool               tryfonts = true,
                bool               trimleft = false);
 
+// Like auto_text() above, but draws on sprite instead of the canvas
+void auto_text(LGFX_Sprite*       sprite,
+               const std::string& txt,
+               int                x,
+               int                y,
+               int                w,
+               int                color,
+               fontnum_t          fontnum  = MEDIUM,
+               int                datum    = middle_center,
+               bool               tryfonts = true,
+               bool               trimleft = false);
+
 void sprite_text(LGFX_Sprite* sprite, const char* msg, int x, int y, int color, fontnum_t fontnum = TINY, int datum = middle_center);
 void text(const char* msg, int x, int y, int color, fontnum_t fontnum = TINY, int datum = middle_center);
 void text(const std::string& msg, int x, int y, int color, fontnum_t fontnum = TINY, int datum = middle_center);
@@ -36,7 +36,7 @@ public:
 
             case Hold:
             case Cycle:
-                fnc_realtime(Reset);
+                reset_fluidnc();
                 break;
 
             default:
@@ -47,7 +47,7 @@ public:
     void onGreenButtonPress() {
         switch (state) {
             case Idle:
-                send_line("M6");
+                send_line("M6", CMD_NO_TIMEOUT);
                 break;
 
             case Hold:
@@ -63,7 +63,7 @@ public:
         }
     }
 
-    void onStateChange(state_t old_state) { reDisplay(); }
+    void onStateChange(state_t old_state) { request_redraw(); }
 
     void onTouchClick() {
         if (state == Idle) {
@@ -74,7 +74,7 @@ public:
     void onEncoder(int delta) {
         if (abs(delta) > 0) {
             rotateNumberLoop(_new_tool, delta, 0, 255);
-            reDisplay();
+            request_redraw();
         }
     }
     void onEntry(void* arg) override {}
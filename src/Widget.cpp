@@ -0,0 +1,103 @@
+// Copyright (c) 2023 Mitch Bradley
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "Widget.h"
+#include "Scene.h"
+
+void Widget::draw() {
+    changed();
+    render();
+    _valid = true;
+}
+
+bool Widget::update() {
+    // changed() must run even when invalid so that it records the values
+    bool dirty = changed() || !_valid;
+    if (!dirty) {
+        return false;
+    }
+    canvas.setClipRect(_x, _y, _width, _height);
+    current_scene->paintBackground();
+    render();
+    canvas.clearClipRect();
+    markDirty(_x, _y, _width, _height);
+    _valid = true;
+    return true;
+}
+
+void DROWidget::set(int hl_digit, bool highlight) {
+    if (_homing || hl_digit != _hl_digit || highlight != _highlight) {
+        _homing    = false;
+        _hl_digit  = hl_digit;
+        _highlight = highlight;
+        _valid     = false;
+    }
+}
+
+void DROWidget::setHoming(bool highlight, bool homed) {
+    if (!_homing || highlight != _highlight || homed != _homed) {
+        _homing    = true;
+        _highlight = highlight;
+        _homed     = homed;
+        _valid     = false;
+    }
+}
+
+bool DROWidget::changed() {
+    pos_t pos    = machine.axes[_axis];
+    int   digits = num_digits();
+    bool  limit  = machine.limits[_axis];
+    if (pos == _pos && digits == _digits && limit == _limit) {
+        return false;
+    }
+    _pos    = pos;
+    _digits = digits;
+    _limit  = limit;
+    return true;
+}
+
+void DROWidget::render() {
+    // The DRO stripe draws at its own y, so each render starts a fresh one
+    DRO dro(_x, _y, _width, _height);
+    if (_homing) {
+        dro.drawHoming(_axis, _highlight, _homed);
+    } else {
+        dro.draw(_axis, _hl_digit, _highlight);
+    }
+}
+
+void TextWidget::set(const char* text, int color) {
+    _text  = text;
+    _color = color;
+}
+
+bool TextWidget::changed() {
+    if (_text == _shown && _color == _shown_color) {
+        return false;
+    }
+    _shown       = _text;
+    _shown_color = _color;
+    return true;
+}
+
+void TextWidget::render() {
+    text(_shown.c_str(), _x + _width / 2, _y + _height / 2, _shown_color, _font, middle_center);
+}
+
+bool ProgressWidget::changed() {
+    if (machine.percent == _percent) {
+        return false;
+    }
+    _percent = machine.percent;
+    return true;
+}
+
+void ProgressWidget::render() {
+    if (_percent > 0) {
+        drawRect(_x, _y, _width, _height, 5, LIGHTGREY);
+        int width = (_width * _percent) / 100;
+        if (width > 0) {
+            drawRect(_x, _y, width, _height, 5, GREEN);
+        }
+    }
+}
@@ -0,0 +1,95 @@
+// Copyright (c) 2023 Mitch Bradley
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+// Retained-mode display elements.  A widget remembers the model values
+// it last rendered and, on update(), repaints only its own rectangle and
+// only when one of those values has changed.  That lets a scene handle
+// a status report by touching a few DROs instead of rebuilding the
+// whole canvas.
+
+#pragma once
+#include "Drawing.h"
+#include <string>
+
+class Widget {
+protected:
+    int  _x;
+    int  _y;
+    int  _width;
+    int  _height;
+    bool _valid = false;
+
+    // changed() compares the bound model values against the ones that
+    // were last rendered, records the new ones, and returns true if any differ.
+    virtual bool changed() = 0;
+    virtual void render()  = 0;
+
+public:
+    Widget(int x, int y, int width, int height) : _x(x), _y(y), _width(width), _height(height) {}
+    virtual ~Widget() {}
+
+    void invalidate() { _valid = false; }
+
+    // draw() renders onto a freshly painted background, as from reDisplay()
+    void draw();
+
+    // update() erases and re-renders the widget in place if its model changed.
+    // Returns true if anything was drawn.
+    bool update();
+};
+
+class DROWidget : public Widget {
+private:
+    int  _axis;
+    bool _homing    = false;
+    int  _hl_digit  = -1;
+    bool _highlight = true;
+    bool _homed     = false;
+
+    pos_t _pos    = 0;
+    int   _digits = 0;
+    bool  _limit  = false;
+
+protected:
+    bool changed() override;
+    void render() override;
+
+public:
+    DROWidget(int x, int y, int width, int height, int axis) : Widget(x, y, width, height), _axis(axis) {}
+
+    // Presentation, as for DRO::draw() and DRO::drawHoming()
+    void set(int hl_digit, bool highlight);
+    void setHoming(bool highlight, bool homed);
+};
+
+class TextWidget : public Widget {
+private:
+    fontnum_t   _font;
+    std::string _text;
+    int         _color = WHITE;
+
+    std::string _shown;
+    int         _shown_color = WHITE;
+
+protected:
+    bool changed() override;
+    void render() override;
+
+public:
+    // The text is centered in the widget rectangle
+    TextWidget(int x, int y, int width, int height, fontnum_t font) : Widget(x, y, width, height), _font(font) {}
+
+    void set(const char* text, int color = WHITE);
+};
+
+class ProgressWidget : public Widget {
+private:
+    file_percent_t _percent = 0;
+
+protected:
+    bool changed() override;
+    void render() override;
+
+public:
+    ProgressWidget(int x, int y, int width, int height) : Widget(x, y, width, height) {}
+};
@@ -5,6 +5,7 @@
 #include "FileParser.h"
 #include "Scene.h"
 #include "AboutScene.h"
+#include "ProtocolTask.h"
 
 extern void base_display();
 extern void show_logo();
@@ -25,6 +26,7 @@ void setup() {
 
     dbg_printf("FluidNC Pendant %s\n", git_info);
 
+    start_protocol_task();
     fnc_realtime(StatusReport);  // Kick FluidNC into action
 
     // init_file_list();
@@ -34,6 +36,8 @@ void setup() {
 }
 
 void loop() {
-    fnc_poll();         // Handle messages from FluidNC
+#ifndef RX_TASK
+    protocol_poll();  // Handle messages from FluidNC
+#endif
     dispatch_events();  // Handle dial, touch, buttons
 }
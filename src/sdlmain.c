@@ -1,6 +1,7 @@
 #ifndef ARDUINO
 #    include <lgfx/v1/platforms/sdl/Panel_sdl.hpp>
-#    if defined(SDL_h_)
+#    if defined(SDL_h_) && !defined(LINUX)
+// The Linux port has its own main() in SystemLinux.cpp
 
 extern void setup();
 extern void loop();
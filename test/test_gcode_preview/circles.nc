@@ -0,0 +1,9 @@
+(A 20 mm circle cut clockwise with I/J, then counterclockwise with R)
+G21 G90
+G0 X-10 Y0
+G1 X-10 Y0 F500
+G2 X10 Y0 I10 J0
+G2 X-10 Y0 I-10 J0
+G3 X10 Y0 R10
+G3 X-10 Y0 R10
+M2
@@ -0,0 +1,9 @@
+(The same square as square_mm.nc, in relative inches)
+G20 G91
+G0 X0 Y0
+G1 X1 F20
+Y1
+X-1
+Y-1
+G90 G21
+M2
@@ -0,0 +1,8 @@
+(25.4 mm square in absolute millimeters)
+G21 G90
+G0 X0 Y0
+G1 X25.4 Y0 F500
+Y25.4
+X0
+Y0
+M2
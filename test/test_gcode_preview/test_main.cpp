@@ -0,0 +1,144 @@
+// Copyright (c) 2024 - Mitch Bradley
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+// Host tests for the toolpath preview interpreter and rasterizer.
+//   pio test -e native_test
+
+#include <unity.h>
+#include "GCodePreview.h"
+
+#include <stdio.h>
+#include <string>
+
+static GCodePreview a;
+static GCodePreview b;
+
+void setUp() {
+    a.reset();
+    b.reset();
+}
+void tearDown() {}
+
+// The sample files are next to this one
+static void parse_file(GCodePreview& preview, const char* name) {
+    std::string path(__FILE__);
+    path = path.substr(0, path.find_last_of("/\\") + 1) + name;
+
+    FILE* f = fopen(path.c_str(), "r");
+    TEST_ASSERT_NOT_NULL_MESSAGE(f, path.c_str());
+    char line[128];
+    while (fgets(line, sizeof(line), f)) {
+        preview.parseLine(line);
+    }
+    fclose(f);
+}
+
+static void parse_lines(GCodePreview& preview, const char* const* lines) {
+    while (*lines) {
+        preview.parseLine(*lines++);
+    }
+}
+
+static bool same_cells(const GCodePreview& p, const GCodePreview& q) {
+    if (p.cellSize() != q.cellSize()) {
+        return false;
+    }
+    for (int n = 0; n < GCodePreview::WORDS; n++) {
+        if (p.word(n) != q.word(n)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void test_absolute_square() {
+    parse_file(a, "square_mm.nc");
+    TEST_ASSERT_EQUAL(8, a.lines());
+
+    int min_x, min_y, max_x, max_y;
+    TEST_ASSERT_TRUE(a.bounds(min_x, min_y, max_x, max_y));
+    TEST_ASSERT_EQUAL(max_x - min_x, max_y - min_y);
+
+    // The outline is drawn and the inside is not
+    TEST_ASSERT_TRUE(a.cell(min_x, min_y));
+    TEST_ASSERT_TRUE(a.cell(max_x, max_y));
+    TEST_ASSERT_TRUE(a.cell(min_x, (min_y + max_y) / 2));
+    TEST_ASSERT_FALSE(a.cell((min_x + max_x) / 2, (min_y + max_y) / 2));
+}
+
+void test_relative_inches() {
+    parse_file(a, "square_mm.nc");
+    parse_file(b, "square_inch.nc");
+    TEST_ASSERT_TRUE(same_cells(a, b));
+}
+
+void test_rapids_are_not_drawn() {
+    const char* lines[] = { "G0 X0 Y0", "G0 X50 Y50", "G1 X50 Y60", nullptr };
+    parse_lines(a, lines);
+
+    int min_x, min_y, max_x, max_y;
+    TEST_ASSERT_TRUE(a.bounds(min_x, min_y, max_x, max_y));
+    TEST_ASSERT_EQUAL(min_x, max_x);  // Only the vertical G1
+}
+
+void test_arcs() {
+    parse_file(a, "circles.nc");
+
+    int min_x, min_y, max_x, max_y;
+    TEST_ASSERT_TRUE(a.bounds(min_x, min_y, max_x, max_y));
+    TEST_ASSERT_INT_WITHIN(1, max_x - min_x, max_y - min_y);
+    TEST_ASSERT_FALSE(a.cell((min_x + max_x) / 2, (min_y + max_y) / 2));
+
+    // The radius form draws the same circle as the center offset form
+    const char* ij[] = { "G90 G0 X-10 Y0", "G2 X10 Y0 I10 J0", "G2 X-10 Y0 I-10 J0", nullptr };
+    const char* r[]  = { "G90 G0 X-10 Y0", "G2 X10 Y0 R10", "G2 X-10 Y0 R10", nullptr };
+    a.reset();
+    parse_lines(a, ij);
+    parse_lines(b, r);
+    TEST_ASSERT_TRUE(same_cells(a, b));
+}
+
+void test_arc_direction() {
+    // A quarter arc from (10, 0) to (0, 10).  Counterclockwise, it runs from
+    // the lower right corner of its bounding box to the upper left.
+    // Clockwise, it sweeps three quarters of the circle, through the bottom.
+    const char* ccw[] = { "G90 G0 X10 Y0", "G3 X0 Y10 I-10 J0", nullptr };
+    const char* cw[]  = { "G90 G0 X10 Y0", "G2 X0 Y10 I-10 J0", nullptr };
+    parse_lines(a, ccw);
+    parse_lines(b, cw);
+
+    int min_x, min_y, max_x, max_y;
+    TEST_ASSERT_TRUE(a.bounds(min_x, min_y, max_x, max_y));
+    TEST_ASSERT_TRUE(a.cell(max_x, min_y));
+    TEST_ASSERT_TRUE(a.cell(min_x, max_y));
+    TEST_ASSERT_FALSE(a.cell(min_x, min_y));
+
+    TEST_ASSERT_TRUE(b.bounds(min_x, min_y, max_x, max_y));
+    TEST_ASSERT_FALSE(b.cell(max_x, min_y));
+    TEST_ASSERT_TRUE(b.cell((min_x + max_x) / 2, min_y));
+}
+
+void test_out_of_range_move() {
+    // The grid stops growing at its maximum cell size, and the part of the
+    // move outside it is clipped instead of stepped cell by cell
+    const char* lines[] = { "G90 G1 X0 Y0", "G1 X10 Y10", "G1 X99999999999 Y-99999999999", "G1 X5 Y5", nullptr };
+    parse_lines(a, lines);
+    TEST_ASSERT_EQUAL(4, a.lines());
+
+    int min_x, min_y, max_x, max_y;
+    TEST_ASSERT_TRUE(a.bounds(min_x, min_y, max_x, max_y));
+    // The move toward +X -Y runs off the grid at one of those edges
+    TEST_ASSERT_TRUE(max_x == GCodePreview::GRID - 1 || min_y == 0);
+    TEST_ASSERT_TRUE(max_x > min_x);
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_absolute_square);
+    RUN_TEST(test_relative_inches);
+    RUN_TEST(test_rapids_are_not_drawn);
+    RUN_TEST(test_arcs);
+    RUN_TEST(test_arc_direction);
+    RUN_TEST(test_out_of_range_move);
+    return UNITY_END();
+}